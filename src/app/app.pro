@@ -4,6 +4,7 @@ include(../libs/qsimpleupdater/qsimpleupdater-include.pri)
 include(../libs/singleapplication/singleapplication-include.pri)
 
 include(../libs/extensionsystem/extensionsystem-include.pri)
+include(../libs/ioc/ioc-include.pri)
 TEMPLATE = app
 TARGET = qtproject
 DESTDIR = $$IDE_APP_PATH
@@ -22,7 +23,8 @@ HEADERS += \
 LIBS *= \
     -l$$qtLibraryName(QSimpleUpdater) \
     -l$$qtLibraryName(SingleApplication) \
-    -l$$qtLibraryName(ExtensionSystem)
+    -l$$qtLibraryName(ExtensionSystem) \
+    -l$$qtLibraryName(Ioc)
 
 target.path = $$INSTALL_APP_PATH
 INSTALLS += target
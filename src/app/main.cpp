@@ -2,12 +2,33 @@
 
 #include "pluginmanager.h"
 #include "iplugin.h"
+#include "startupprofiler.h"
+#include "dicontainer.h"
 
 const char corePluginNameC[] = "Core";
 
 int main(int argc, char *argv[])
 {
+    //--startup-profile[=文件] 或环境变量 QTPROJECT_STARTUP_PROFILE 开启启动耗时记录
+    if (StartupProfiler::enableFromArguments(argc, argv))
+    {
+        //只记录单例的构造，瞬态对象随导航创建，不属于启动阶段
+        Ioc::DIContainer::SetConstructionHook([](const QString &typeName, bool isSingletonInstance, const std::function<void()> &construct) {
+            if (!isSingletonInstance)
+            {
+                construct();
+                return;
+            }
+            StartupProfiler::Scope scope;
+            if (StartupProfiler::isEnabled())
+                scope.start("ioc", "construct " + typeName);
+            construct();
+        });
+    }
+
+    StartupProfiler::Scope applicationScope("app", "QApplication");
     QApplication a(argc, argv);
+    applicationScope.finish();
 
     PluginManager::instance()->loadAllPlugins();//插件管理器 加载所有插件
 //    auto loader = PluginManager::instance()->getPlugin(corePluginNameC);
@@ -16,5 +37,6 @@ int main(int argc, char *argv[])
 //        auto corePlugin = static_cast<IPlugin*>(loader->instance());
 //        corePlugin->initialize();
 //    }
+    StartupProfiler::traceFirstPaint();
     return a.exec();
 }
@@ -54,6 +54,7 @@
 #include "DockAreaTitleBar.h"
 #include "DockComponentsFactory.h"
 #include "DockWidgetTab.h"
+#include "DockLayoutState.h"
 
 
 namespace ads
@@ -802,6 +803,26 @@ void CDockAreaWidget::saveState(QXmlStreamWriter& s) const
 }
 
 
+//============================================================================
+void CDockAreaWidget::saveState(DockLayoutNode& Node) const
+{
+	Node.Type = DockLayoutNode::Area;
+	auto CurrentDockWidget = currentDockWidget();
+	Node.CurrentDockWidget = CurrentDockWidget ? CurrentDockWidget->objectName() : "";
+	// Like the XML data, we only save the allowed areas and the dock area
+	// flags if the values are different from the default values
+	Node.AllowedAreas = (d->AllowedAreas != DefaultAllowedAreas) ? int(d->AllowedAreas) : -1;
+	Node.Flags = (d->Flags != DefaultFlags) ? int(d->Flags) : -1;
+	for (int i = 0; i < d->ContentsLayout->count(); ++i)
+	{
+		DockLayoutWidget Widget;
+		Widget.Name = dockWidget(i)->objectName();
+		Widget.Closed = dockWidget(i)->isClosed();
+		Node.DockWidgets.append(Widget);
+	}
+}
+
+
 //============================================================================
 CDockWidget* CDockAreaWidget::nextOpenDockWidget(CDockWidget* DockWidget) const
 {
@@ -41,6 +41,7 @@ QT_FORWARD_DECLARE_CLASS(QAbstractButton)
 namespace ads
 {
 struct DockAreaWidgetPrivate;
+struct DockLayoutNode;
 class CDockManager;
 class CDockContainerWidget;
 class DockContainerWidgetPrivate;
@@ -262,6 +263,11 @@ public:
 	 */
 	void saveState(QXmlStreamWriter& Stream) const;
 
+	/**
+	 * Saves the state into the given layout node
+	 */
+	void saveState(DockLayoutNode& Node) const;
+
 	/**
 	 * This functions returns the dock widget features of all dock widget in
 	 * this area.
@@ -42,7 +42,7 @@
 #include "DockManager.h"
 #include "DockAreaWidget.h"
 #include "DockWidget.h"
-#include "DockingStateReader.h"
+#include "DockLayoutState.h"
 #include "FloatingDockContainer.h"
 #include "DockOverlay.h"
 #include "ads_globals.h"
@@ -212,29 +212,47 @@ public:
 	void saveChildNodesState(QXmlStreamWriter& Stream, QWidget* Widget);
 
 	/**
-	 * Restore state of child nodes.
-	 * \param[in] Stream The data stream that contains the serialized state
-	 * \param[out] CreatedWidget The widget created from parsed data or 0 if
-	 * the parsed widget was an empty splitter
-	 * \param[in] Testing If Testing is true, only the stream data is
-	 * parsed without modifiying anything.
+	 * Save state of child nodes into the given layout node.
+	 * Returns false if the widget is neither a splitter nor a dock area
 	 */
-	bool restoreChildNodes(CDockingStateReader& Stream, QWidget*& CreatedWidget,
-		bool Testing);
+	bool saveChildNodesState(DockLayoutNode& Node, QWidget* Widget);
+
+	/**
+	 * Restore state of child nodes from an already validated layout node.
+	 * Returns the created widget or 0 if the node was an empty splitter
+	 * or a dock area without any known dock widget
+	 */
+	QWidget* restoreChildNodes(const DockLayoutNode& Node);
 
 	/**
 	 * Restores a splitter.
 	 * \see restoreChildNodes() for details
 	 */
-	bool restoreSplitter(CDockingStateReader& Stream, QWidget*& CreatedWidget,
-		bool Testing);
+	QWidget* restoreSplitter(const DockLayoutNode& Node);
 
 	/**
 	 * Restores a dock area.
 	 * \see restoreChildNodes() for details
 	 */
-	bool restoreDockArea(CDockingStateReader& Stream, QWidget*& CreatedWidget,
-		bool Testing);
+	QWidget* restoreDockArea(const DockLayoutNode& Node);
+
+	/**
+	 * Returns true if the given widget has the same splitters and dock areas
+	 * with the same dock widgets as the given layout node
+	 */
+	bool hasSameStructure(const DockLayoutNode& Node, QWidget* Widget) const;
+
+	/**
+	 * Applies the dock area settings, the open state of the dock widgets
+	 * and the current dock widget of the layout node to the existing
+	 * dock areas
+	 */
+	void applyDockAreasState(const DockLayoutNode& Node, QWidget* Widget);
+
+	/**
+	 * Applies the splitter sizes of the layout node to the existing splitters
+	 */
+	void applySplitterSizes(const DockLayoutNode& Node, QWidget* Widget);
 
 	/**
 	 * Helper function for recursive dumping of layout
@@ -875,79 +893,46 @@ void DockContainerWidgetPrivate::saveChildNodesState(QXmlStreamWriter& s, QWidge
 
 
 //============================================================================
-bool DockContainerWidgetPrivate::restoreSplitter(CDockingStateReader& s,
-	QWidget*& CreatedWidget, bool Testing)
+bool DockContainerWidgetPrivate::saveChildNodesState(DockLayoutNode& Node, QWidget* Widget)
 {
-	bool Ok;
-	QString OrientationStr = s.attributes().value("Orientation").toString();
-
-	// Check if the orientation string is right
-	if (!OrientationStr.startsWith("|") && !OrientationStr.startsWith("-"))
+	QSplitter* Splitter = qobject_cast<QSplitter*>(Widget);
+	if (Splitter)
 	{
-		return false;
+		Node.Type = DockLayoutNode::Splitter;
+		Node.Orientation = Splitter->orientation();
+		for (int i = 0; i < Splitter->count(); ++i)
+		{
+			DockLayoutNode ChildNode;
+			if (saveChildNodesState(ChildNode, Splitter->widget(i)))
+			{
+				Node.Children.append(ChildNode);
+			}
+		}
+		Node.Sizes = Splitter->sizes();
+		return true;
 	}
 
-	// The "|" shall indicate a vertical splitter handle which in turn means
-	// a Horizontal orientation of the splitter layout.
-	bool HorizontalSplitter = OrientationStr.startsWith("|");
-	// In version 0 we had a small bug. The "|" indicated a vertical orientation,
-	// but this is wrong, because only the splitter handle is vertical, the
-	// layout of the splitter is a horizontal layout. We fix this here
-	if (s.fileVersion() == 0)
+	CDockAreaWidget* DockArea = qobject_cast<CDockAreaWidget*>(Widget);
+	if (DockArea)
 	{
-		HorizontalSplitter = !HorizontalSplitter;
+		DockArea->saveState(Node);
+		return true;
 	}
+	return false;
+}
 
-	int Orientation = HorizontalSplitter ? Qt::Horizontal : Qt::Vertical;
-	int WidgetCount = s.attributes().value("Count").toInt(&Ok);
-	if (!Ok)
-	{
-		return false;
-	}
-    ADS_PRINT("Restore NodeSplitter Orientation: " <<  Orientation <<
-            " WidgetCount: " << WidgetCount);
-	QSplitter* Splitter = nullptr;
-	if (!Testing)
-	{
-		Splitter = newSplitter(static_cast<Qt::Orientation>(Orientation));
-	}
+
+//============================================================================
+QWidget* DockContainerWidgetPrivate::restoreSplitter(const DockLayoutNode& Node)
+{
+    ADS_PRINT("Restore NodeSplitter Orientation: " <<  Node.Orientation <<
+            " WidgetCount: " << Node.Sizes.count());
+	QSplitter* Splitter = newSplitter(Node.Orientation);
 	bool Visible = false;
-	QList<int> Sizes;
-	while (s.readNextStartElement())
+	for (const auto& Child : Node.Children)
 	{
-		QWidget* ChildNode = nullptr;
-		bool Result = true;
-        if (s.name() == QLatin1String("Splitter"))
-		{
-			Result = restoreSplitter(s, ChildNode, Testing);
-		}
-        else if (s.name() == QLatin1String("Area"))
-		{
-			Result = restoreDockArea(s, ChildNode, Testing);
-		}
-        else if (s.name() == QLatin1String("Sizes"))
-		{
-			QString sSizes = s.readElementText().trimmed();
-            ADS_PRINT("Sizes: " << sSizes);
-			QTextStream TextStream(&sSizes);
-			while (!TextStream.atEnd())
-			{
-				int value;
-				TextStream >> value;
-				Sizes.append(value);
-			}
-		}
-		else
-		{
-			s.skipCurrentElement();
-		}
-
-		if (!Result)
-		{
-			return false;
-		}
-
-		if (Testing || !ChildNode)
+		QWidget* ChildNode = restoreChildNodes(Child);
+		if (!ChildNode)
 		{
 			continue;
 		}
@@ -957,156 +942,203 @@ bool DockContainerWidgetPrivate::restoreSplitter(CDockingStateReader& s,
 		Splitter->addWidget(ChildNode);
 		Visible |= ChildNode->isVisibleTo(Splitter);
 	}
-    if(!Testing)
-    {
-       updateSplitterHandles(Splitter);
-    }
+	updateSplitterHandles(Splitter);
 
-	if (Sizes.count() != WidgetCount)
+	if (!Splitter->count())
 	{
-		return false;
+		delete Splitter;
+		return nullptr;
 	}
 
-	if (!Testing)
+	Splitter->setSizes(Node.Sizes);
+	Splitter->setVisible(Visible);
+	return Splitter;
+}
+
+
+//============================================================================
+QWidget* DockContainerWidgetPrivate::restoreDockArea(const DockLayoutNode& Node)
+{
+    ADS_PRINT("Restore NodeDockArea Tabs: " << Node.DockWidgets.count() << " Current: "
+            << Node.CurrentDockWidget);
+
+	CDockAreaWidget* DockArea = new CDockAreaWidget(DockManager, _this);
+	if (Node.AllowedAreas >= 0)
 	{
-		if (!Splitter->count())
-		{
-			delete Splitter;
-			Splitter = nullptr;
-		}
-		else
+		DockArea->setAllowedAreas((DockWidgetArea)Node.AllowedAreas);
+	}
+
+	if (Node.Flags >= 0)
+	{
+		DockArea->setDockAreaFlags((CDockAreaWidget::DockAreaFlags)Node.Flags);
+	}
+
+	for (const auto& Widget : Node.DockWidgets)
+	{
+		CDockWidget* DockWidget = DockManager->findDockWidget(Widget.Name);
+		if (!DockWidget)
 		{
-			Splitter->setSizes(Sizes);
-			Splitter->setVisible(Visible);
+			continue;
 		}
-		CreatedWidget = Splitter;
+
+        ADS_PRINT("Dock Widget found - parent " << DockWidget->parent());
+		// We hide the DockArea here to prevent the short display (the flashing)
+		// of the dock areas during application startup
+		DockArea->hide();
+		DockArea->addDockWidget(DockWidget);
+		DockWidget->setToggleViewActionChecked(!Widget.Closed);
+		DockWidget->setClosedState(Widget.Closed);
+		DockWidget->setProperty(internal::ClosedProperty, Widget.Closed);
+		DockWidget->setProperty(internal::DirtyProperty, false);
 	}
-	else
+
+	if (!DockArea->dockWidgetsCount())
 	{
-		CreatedWidget = nullptr;
+		delete DockArea;
+		return nullptr;
 	}
 
-	return true;
+	DockArea->setProperty("currentDockWidget", Node.CurrentDockWidget);
+	appendDockAreas({DockArea});
+	return DockArea;
 }
 
 
 //============================================================================
-bool DockContainerWidgetPrivate::restoreDockArea(CDockingStateReader& s,
-	QWidget*& CreatedWidget, bool Testing)
+QWidget* DockContainerWidgetPrivate::restoreChildNodes(const DockLayoutNode& Node)
 {
-	bool Ok;
-#ifdef ADS_DEBUG_PRINT
-	int Tabs = s.attributes().value("Tabs").toInt(&Ok);
-	if (!Ok)
+	if (Node.Type == DockLayoutNode::Splitter)
 	{
-		return false;
+		return restoreSplitter(Node);
 	}
-#endif
+	else
+	{
+		return restoreDockArea(Node);
+	}
+}
 
-	QString CurrentDockWidget = s.attributes().value("Current").toString();
-    ADS_PRINT("Restore NodeDockArea Tabs: " << Tabs << " Current: "
-            << CurrentDockWidget);
 
-	CDockAreaWidget* DockArea = nullptr;
-	if (!Testing)
+//============================================================================
+bool DockContainerWidgetPrivate::hasSameStructure(const DockLayoutNode& Node,
+	QWidget* Widget) const
+{
+	if (Node.Type == DockLayoutNode::Splitter)
 	{
-		DockArea = new CDockAreaWidget(DockManager, _this);
-		const auto AllowedAreasAttribute = s.attributes().value("AllowedAreas");
-		if (!AllowedAreasAttribute.isEmpty())
+		QSplitter* Splitter = qobject_cast<QSplitter*>(Widget);
+		if (!Splitter || Splitter->orientation() != Node.Orientation
+		 || Splitter->count() != Node.Children.count())
 		{
-			DockArea->setAllowedAreas((DockWidgetArea)AllowedAreasAttribute.toInt(nullptr, 16));
+			return false;
 		}
 
-		const auto FlagsAttribute = s.attributes().value("Flags");
-		if (!FlagsAttribute.isEmpty())
+		for (int i = 0; i < Splitter->count(); ++i)
 		{
-			DockArea->setDockAreaFlags((CDockAreaWidget::DockAreaFlags)FlagsAttribute.toInt(nullptr, 16));
+			if (!hasSameStructure(Node.Children[i], Splitter->widget(i)))
+			{
+				return false;
+			}
 		}
+		return true;
 	}
 
-	while (s.readNextStartElement())
+	CDockAreaWidget* DockArea = qobject_cast<CDockAreaWidget*>(Widget);
+	if (!DockArea || DockArea->dockWidgetsCount() != Node.DockWidgets.count())
 	{
-        if (s.name() != QLatin1String("Widget"))
-		{
-			continue;
-		}
+		return false;
+	}
 
-		auto ObjectName = s.attributes().value("Name");
-		if (ObjectName.isEmpty())
+	for (int i = 0; i < DockArea->dockWidgetsCount(); ++i)
+	{
+		if (DockArea->dockWidget(i)->objectName() != Node.DockWidgets[i].Name)
 		{
 			return false;
 		}
+	}
+	return true;
+}
+
 
-		bool Closed = s.attributes().value("Closed").toInt(&Ok);
-		if (!Ok)
+//============================================================================
+void DockContainerWidgetPrivate::applyDockAreasState(const DockLayoutNode& Node,
+	QWidget* Widget)
+{
+	if (Node.Type == DockLayoutNode::Splitter)
+	{
+		QSplitter* Splitter = qobject_cast<QSplitter*>(Widget);
+		for (int i = 0; i < Node.Children.count(); ++i)
 		{
-			return false;
+			applyDockAreasState(Node.Children[i], Splitter->widget(i));
 		}
+		return;
+	}
 
-		s.skipCurrentElement();
-		CDockWidget* DockWidget = DockManager->findDockWidget(ObjectName.toString());
-		if (!DockWidget || Testing)
+	CDockAreaWidget* DockArea = qobject_cast<CDockAreaWidget*>(Widget);
+	DockArea->setAllowedAreas((Node.AllowedAreas >= 0)
+		? (DockWidgetArea)Node.AllowedAreas : AllDockAreas);
+	DockArea->setDockAreaFlags((Node.Flags >= 0)
+		? (CDockAreaWidget::DockAreaFlags)Node.Flags : CDockAreaWidget::DefaultFlags);
+
+	// We open the dock widgets before we close the others. If we would close
+	// first, the dock area would be hidden and shown again if all its open
+	// dock widgets are replaced
+	for (int i = 0; i < Node.DockWidgets.count(); ++i)
+	{
+		CDockWidget* DockWidget = DockArea->dockWidget(i);
+		if (!Node.DockWidgets[i].Closed && DockWidget->isClosed())
 		{
-			continue;
+			DockWidget->toggleView(true);
 		}
-
-        ADS_PRINT("Dock Widget found - parent " << DockWidget->parent());
-		// We hide the DockArea here to prevent the short display (the flashing)
-		// of the dock areas during application startup
-		DockArea->hide();
-		DockArea->addDockWidget(DockWidget);
-		DockWidget->setToggleViewActionChecked(!Closed);
-		DockWidget->setClosedState(Closed);
-		DockWidget->setProperty(internal::ClosedProperty, Closed);
-		DockWidget->setProperty(internal::DirtyProperty, false);
 	}
 
-	if (Testing)
+	for (int i = 0; i < Node.DockWidgets.count(); ++i)
 	{
-		return true;
+		CDockWidget* DockWidget = DockArea->dockWidget(i);
+		if (Node.DockWidgets[i].Closed && !DockWidget->isClosed())
+		{
+			DockWidget->toggleView(false);
+		}
 	}
 
-	if (!DockArea->dockWidgetsCount())
+	// setCurrentDockWidget() is blocked while the dock manager restores a
+	// state, so we need to use the internal function here
+	CDockWidget* CurrentDockWidget = DockManager->findDockWidget(Node.CurrentDockWidget);
+	if (CurrentDockWidget && CurrentDockWidget->dockAreaWidget() == DockArea
+	 && !CurrentDockWidget->isClosed())
 	{
-		delete DockArea;
-		DockArea = nullptr;
+		DockArea->internalSetCurrentDockWidget(CurrentDockWidget);
 	}
-	else
+	else if (DockArea->currentDockWidget() && DockArea->currentDockWidget()->isClosed())
 	{
-		DockArea->setProperty("currentDockWidget", CurrentDockWidget);
-		appendDockAreas({DockArea});
+		int Index = DockArea->indexOfFirstOpenDockWidget();
+		if (Index >= 0)
+		{
+			DockArea->setCurrentIndex(Index);
+		}
 	}
-
-	CreatedWidget = DockArea;
-	return true;
 }
 
 
 //============================================================================
-bool DockContainerWidgetPrivate::restoreChildNodes(CDockingStateReader& s,
-	QWidget*& CreatedWidget, bool Testing)
+void DockContainerWidgetPrivate::applySplitterSizes(const DockLayoutNode& Node,
+	QWidget* Widget)
 {
-	bool Result = true;
-	while (s.readNextStartElement())
+	QSplitter* Splitter = qobject_cast<QSplitter*>(Widget);
+	if (!Splitter)
 	{
-        if (s.name() == QLatin1String("Splitter"))
-		{
-			Result = restoreSplitter(s, CreatedWidget, Testing);
-            ADS_PRINT("Splitter");
-		}
-        else if (s.name() == QLatin1String("Area"))
-		{
-			Result = restoreDockArea(s, CreatedWidget, Testing);
-            ADS_PRINT("DockAreaWidget");
-		}
-		else
-		{
-			s.skipCurrentElement();
-            ADS_PRINT("Unknown element");
-		}
+		return;
 	}
 
-	return Result;
+	// The children first, because a nested splitter does not change the
+	// sizes of its parent splitter
+	for (int i = 0; i < Node.Children.count(); ++i)
+	{
+		applySplitterSizes(Node.Children[i], Splitter->widget(i));
+	}
+
+	if (Splitter->sizes() != Node.Sizes)
+	{
+		Splitter->setSizes(Node.Sizes);
+	}
 }
 
 
@@ -1664,56 +1696,39 @@ void CDockContainerWidget::saveState(QXmlStreamWriter& s) const
 
 
 //============================================================================
-bool CDockContainerWidget::restoreState(CDockingStateReader& s, bool Testing)
+void CDockContainerWidget::saveState(DockLayoutContainer& Layout) const
 {
-	bool IsFloating = s.attributes().value("Floating").toInt();
-    ADS_PRINT("Restore CDockContainerWidget Floating" << IsFloating);
-
-	QWidget*NewRootSplitter {};
-	if (!Testing)
+	Layout.Floating = isFloating();
+	if (Layout.Floating)
 	{
-		d->VisibleDockAreaCount = -1;// invalidate the dock area count
-		d->DockAreas.clear();
-		std::fill(std::begin(d->LastAddedAreaCache),std::end(d->LastAddedAreaCache), nullptr);
+		Layout.Geometry = floatingWidget()->saveGeometry();
 	}
+	Layout.HasRoot = d->saveChildNodesState(Layout.Root, d->RootSplitter);
+}
 
-	if (IsFloating)
-	{
-        ADS_PRINT("Restore floating widget");
-        if (!s.readNextStartElement() || s.name() != QLatin1String("Geometry"))
-		{
-			return false;
-		}
-
-		QByteArray GeometryString = s.readElementText(CDockingStateReader::ErrorOnUnexpectedElement).toLocal8Bit();
-		QByteArray Geometry = QByteArray::fromHex(GeometryString);
-		if (Geometry.isEmpty())
-		{
-			return false;
-		}
 
-		if (!Testing)
-		{
-			CFloatingDockContainer* FloatingWidget = floatingWidget();
-			if (FloatingWidget)
-			{
-				FloatingWidget->restoreGeometry(Geometry);
-			}
-		}
-	}
+//============================================================================
+bool CDockContainerWidget::restoreState(const DockLayoutContainer& Layout)
+{
+    ADS_PRINT("Restore CDockContainerWidget Floating" << Layout.Floating);
 
-	if (!d->restoreChildNodes(s, NewRootSplitter, Testing))
-	{
-		return false;
-	}
+	d->VisibleDockAreaCount = -1;// invalidate the dock area count
+	d->DockAreas.clear();
+	std::fill(std::begin(d->LastAddedAreaCache),std::end(d->LastAddedAreaCache), nullptr);
 
-	if (Testing)
+	if (Layout.Floating)
 	{
-		return true;
+        ADS_PRINT("Restore floating widget");
+		CFloatingDockContainer* FloatingWidget = floatingWidget();
+		if (FloatingWidget)
+		{
+			FloatingWidget->restoreGeometry(Layout.Geometry);
+		}
 	}
 
 	// If the root splitter is empty, rostoreChildNodes returns a 0 pointer
 	// and we need to create a new empty root splitter
+	QWidget* NewRootSplitter = Layout.HasRoot ? d->restoreChildNodes(Layout.Root) : nullptr;
 	if (!NewRootSplitter)
 	{
 		NewRootSplitter = d->newSplitter(Qt::Horizontal);
@@ -1728,6 +1743,45 @@ bool CDockContainerWidget::restoreState(CDockingStateReader& s, bool Testing)
 }
 
 
+//============================================================================
+bool CDockContainerWidget::hasSameStructure(const DockLayoutContainer& Layout) const
+{
+	if (Layout.Floating != isFloating())
+	{
+		return false;
+	}
+
+	if (!Layout.HasRoot)
+	{
+		return d->RootSplitter->count() == 0;
+	}
+
+	return d->hasSameStructure(Layout.Root, d->RootSplitter);
+}
+
+
+//============================================================================
+void CDockContainerWidget::applyState(const DockLayoutContainer& Layout)
+{
+	if (Layout.Floating)
+	{
+		CFloatingDockContainer* FloatingWidget = floatingWidget();
+		if (FloatingWidget && FloatingWidget->saveGeometry() != Layout.Geometry)
+		{
+			FloatingWidget->restoreGeometry(Layout.Geometry);
+		}
+	}
+
+	if (!Layout.HasRoot)
+	{
+		return;
+	}
+
+	d->applyDockAreasState(Layout.Root, d->RootSplitter);
+	d->applySplitterSizes(Layout.Root, d->RootSplitter);
+}
+
+
 //============================================================================
 QSplitter* CDockContainerWidget::rootSplitter() const
 {
@@ -49,7 +49,7 @@ class CFloatingDockContainer;
 struct FloatingDockContainerPrivate;
 class CFloatingDragPreview;
 struct FloatingDragPreviewPrivate;
-class CDockingStateReader;
+struct DockLayoutContainer;
 
 /**
  * Container that manages a number of dock areas with single dock widgets
@@ -120,12 +120,33 @@ protected:
 	void saveState(QXmlStreamWriter& Stream) const;
 
 	/**
-	 * Restores the state from given stream.
-	 * If Testing is true, the function only parses the data from the given
-	 * stream but does not restore anything. You can use this check for
-	 * faulty files before you start restoring the state
+	 * Saves the state into the given layout tree
 	 */
-	bool restoreState(CDockingStateReader& Stream, bool Testing);
+	void saveState(DockLayoutContainer& Layout) const;
+
+	/**
+	 * Restores the state from the given layout tree.
+	 * The layout has to be parsed and validated before via
+	 * DockLayoutState::fromByteArray()
+	 */
+	bool restoreState(const DockLayoutContainer& Layout);
+
+	/**
+	 * Returns true if the given layout tree has the same structure as this
+	 * container - the same splitters and dock areas containing the same
+	 * dock widgets in the same order. Such a layout can be applied with
+	 * applyState() without rebuilding the container.
+	 */
+	bool hasSameStructure(const DockLayoutContainer& Layout) const;
+
+	/**
+	 * Applies a layout tree with the same structure in place. The existing
+	 * splitters and dock areas are reused - only the open state of the
+	 * dock widgets, the current dock widgets, the splitter sizes and the
+	 * floating widget geometry are changed if they differ.
+	 * \see hasSameStructure()
+	 */
+	void applyState(const DockLayoutContainer& Layout);
 
 	/**
 	 * This function returns the last added dock area widget for the given
@@ -0,0 +1,160 @@
+//============================================================================
+/// \file   DockDropTargetIndex.cpp
+/// \date   18.10.2026
+/// \brief  Implementation of CDockDropTargetIndex
+//============================================================================
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+#include "DockDropTargetIndex.h"
+
+#include <algorithm>
+
+#include "DockManager.h"
+#include "DockContainerWidget.h"
+#include "DockAreaWidget.h"
+
+namespace ads
+{
+//============================================================================
+CDockDropTargetIndex::CDockDropTargetIndex(CDockManager* DockManager, QObject* parent) :
+	QObject(parent),
+	DockManager(DockManager)
+{
+	if (DockManager)
+	{
+		connect(DockManager, &CDockManager::floatingWidgetCreated, this,
+			&CDockDropTargetIndex::invalidate);
+	}
+}
+
+
+//============================================================================
+void CDockDropTargetIndex::setExcludedContainer(CDockContainerWidget* Container)
+{
+	if (ExcludedContainer != Container)
+	{
+		ExcludedContainer = Container;
+		invalidate();
+	}
+}
+
+
+//============================================================================
+void CDockDropTargetIndex::invalidate()
+{
+	if (!Valid)
+	{
+		return;
+	}
+
+	Valid = false;
+	Containers.clear();
+	for (const auto& Connection : Connections)
+	{
+		disconnect(Connection);
+	}
+	Connections.clear();
+}
+
+
+//============================================================================
+void CDockDropTargetIndex::build()
+{
+	invalidate();
+	if (!DockManager)
+	{
+		return;
+	}
+
+	for (auto Container : DockManager->dockContainers())
+	{
+		if (!Container->isVisible() || Container == ExcludedContainer)
+		{
+			continue;
+		}
+
+		ContainerEntry Entry;
+		Entry.Container = Container;
+		Entry.GlobalRect = QRect(Container->mapToGlobal(QPoint(0, 0)), Container->size());
+		Entry.ZOrderIndex = Container->zOrderIndex();
+		Entry.VisibleDockAreas = 0;
+		for (int i = 0; i < Container->dockAreaCount(); ++i)
+		{
+			CDockAreaWidget* DockArea = Container->dockArea(i);
+			if (DockArea->isHidden())
+			{
+				continue;
+			}
+
+			// visibleDockAreaCount() counts the areas that are not hidden,
+			// but only visible areas can be hit
+			Entry.VisibleDockAreas++;
+			if (DockArea->isVisible())
+			{
+				Entry.DockAreas.append({QRect(DockArea->mapToGlobal(QPoint(0, 0)),
+					DockArea->size()), DockArea});
+			}
+		}
+		Containers.append(Entry);
+
+		// Any change of the dock areas of a container makes the captured
+		// rectangles invalid
+		Connections.append(connect(Container, &CDockContainerWidget::dockAreasAdded,
+			this, &CDockDropTargetIndex::invalidate));
+		Connections.append(connect(Container, &CDockContainerWidget::dockAreasRemoved,
+			this, &CDockDropTargetIndex::invalidate));
+		Connections.append(connect(Container, &CDockContainerWidget::dockAreaViewToggled,
+			this, &CDockDropTargetIndex::invalidate));
+		Connections.append(connect(Container, &QObject::destroyed,
+			this, &CDockDropTargetIndex::invalidate));
+	}
+
+	// The front most container comes first. The stable sort keeps the order
+	// of the dock manager for containers with the same z order index - like
+	// the isInFrontOf() checks did before
+	std::stable_sort(Containers.begin(), Containers.end(),
+		[](const ContainerEntry& a, const ContainerEntry& b)
+		{
+			return a.ZOrderIndex > b.ZOrderIndex;
+		});
+	Valid = true;
+}
+
+
+//============================================================================
+CDockDropTargetIndex::HitResult CDockDropTargetIndex::hitTest(const QPoint& GlobalPos)
+{
+	if (!Valid)
+	{
+		build();
+	}
+
+	HitResult Result;
+	for (const auto& Entry : Containers)
+	{
+		if (!Entry.GlobalRect.contains(GlobalPos))
+		{
+			continue;
+		}
+
+		Result.Container = Entry.Container;
+		Result.VisibleDockAreas = Entry.VisibleDockAreas;
+		for (const auto& Area : Entry.DockAreas)
+		{
+			if (Area.GlobalRect.contains(GlobalPos))
+			{
+				Result.DockArea = Area.DockArea;
+				break;
+			}
+		}
+		break;
+	}
+
+	return Result;
+}
+} // namespace ads
+
+//---------------------------------------------------------------------------
+// EOF DockDropTargetIndex.cpp
@@ -0,0 +1,101 @@
+#ifndef DockDropTargetIndexH
+#define DockDropTargetIndexH
+//============================================================================
+/// \file   DockDropTargetIndex.h
+/// \date   18.10.2026
+/// \brief  Declaration of CDockDropTargetIndex
+//============================================================================
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+#include <QObject>
+#include <QList>
+#include <QPointer>
+#include <QRect>
+#include <QVector>
+
+namespace ads
+{
+class CDockManager;
+class CDockContainerWidget;
+class CDockAreaWidget;
+
+/**
+ * Index of the drop targets of a drag operation in global coordinates.
+ * The screen rectangles of all visible dock containers and dock areas are
+ * captured once, the first time the index is queried during a drag. Each
+ * mouse move is then a single point query without any mapFromGlobal()
+ * calls. The index invalidates itself if dock areas are added, removed
+ * or toggled or if a floating widget is created and is rebuilt with the
+ * next query.
+ */
+class CDockDropTargetIndex : public QObject
+{
+	Q_OBJECT
+public:
+	/**
+	 * Result of a point query
+	 */
+	struct HitResult
+	{
+		CDockContainerWidget* Container = nullptr;
+		CDockAreaWidget* DockArea = nullptr;
+		int VisibleDockAreas = 0;
+	};
+
+	/**
+	 * Creates an empty index for the containers of the given dock manager
+	 */
+	CDockDropTargetIndex(CDockManager* DockManager, QObject* parent = nullptr);
+
+	/**
+	 * Excludes the given container from the index. This is the container
+	 * of the floating widget that is dragged.
+	 */
+	void setExcludedContainer(CDockContainerWidget* Container);
+
+	/**
+	 * Discards the captured rectangles. Call this when a drag starts or
+	 * ends, because the layout may change between two drag operations
+	 */
+	void invalidate();
+
+	/**
+	 * Returns the top most container and the dock area in this container
+	 * at the given global position. Builds the index if required.
+	 */
+	HitResult hitTest(const QPoint& GlobalPos);
+
+private:
+	struct DockAreaEntry
+	{
+		QRect GlobalRect;
+		CDockAreaWidget* DockArea;
+	};
+
+	struct ContainerEntry
+	{
+		QRect GlobalRect;
+		CDockContainerWidget* Container;
+		unsigned int ZOrderIndex;
+		int VisibleDockAreas;
+		QVector<DockAreaEntry> DockAreas;
+	};
+
+	/**
+	 * Captures the global rectangles of all visible containers and
+	 * dock areas, sorted from the front most container to the back
+	 */
+	void build();
+
+	QPointer<CDockManager> DockManager;
+	CDockContainerWidget* ExcludedContainer = nullptr;
+	QVector<ContainerEntry> Containers;
+	QList<QMetaObject::Connection> Connections;
+	bool Valid = false;
+};
+} // namespace ads
+
+//---------------------------------------------------------------------------
+#endif // DockDropTargetIndexH
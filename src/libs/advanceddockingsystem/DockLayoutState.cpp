@@ -0,0 +1,470 @@
+//============================================================================
+/// \file   DockLayoutState.cpp
+/// \date   18.10.2026
+/// \brief  Implementation of the in-memory dock layout tree
+//============================================================================
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+#include "DockLayoutState.h"
+
+#include <QDataStream>
+#include <QTextStream>
+
+#include "DockingStateReader.h"
+
+namespace ads
+{
+/**
+ * Magic number and format version at the start of binary layout data
+ */
+static const quint32 BinaryMagic = 0x41445342; // "ADSB"
+static const quint8 BinaryFormatVersion = 1;
+
+
+//============================================================================
+static bool readXmlNode(CDockingStateReader& s, DockLayoutNode& Node);
+
+
+//============================================================================
+static bool readXmlSplitter(CDockingStateReader& s, DockLayoutNode& Node)
+{
+	bool Ok;
+	QString OrientationStr = s.attributes().value("Orientation").toString();
+
+	// Check if the orientation string is right
+	if (!OrientationStr.startsWith("|") && !OrientationStr.startsWith("-"))
+	{
+		return false;
+	}
+
+	// The "|" shall indicate a vertical splitter handle which in turn means
+	// a Horizontal orientation of the splitter layout.
+	bool HorizontalSplitter = OrientationStr.startsWith("|");
+	// In version 0 we had a small bug. The "|" indicated a vertical orientation,
+	// but this is wrong, because only the splitter handle is vertical, the
+	// layout of the splitter is a horizontal layout. We fix this here
+	if (s.fileVersion() == 0)
+	{
+		HorizontalSplitter = !HorizontalSplitter;
+	}
+
+	Node.Type = DockLayoutNode::Splitter;
+	Node.Orientation = HorizontalSplitter ? Qt::Horizontal : Qt::Vertical;
+	int WidgetCount = s.attributes().value("Count").toInt(&Ok);
+	if (!Ok)
+	{
+		return false;
+	}
+
+	while (s.readNextStartElement())
+	{
+		if (s.name() == QLatin1String("Sizes"))
+		{
+			QString sSizes = s.readElementText().trimmed();
+			QTextStream TextStream(&sSizes);
+			while (!TextStream.atEnd())
+			{
+				int value;
+				TextStream >> value;
+				Node.Sizes.append(value);
+			}
+			continue;
+		}
+
+		DockLayoutNode ChildNode;
+		if (s.name() != QLatin1String("Splitter") && s.name() != QLatin1String("Area"))
+		{
+			s.skipCurrentElement();
+			continue;
+		}
+
+		if (!readXmlNode(s, ChildNode))
+		{
+			return false;
+		}
+		Node.Children.append(ChildNode);
+	}
+
+	return Node.Sizes.count() == WidgetCount;
+}
+
+
+//============================================================================
+static bool readXmlArea(CDockingStateReader& s, DockLayoutNode& Node)
+{
+	bool Ok;
+	Node.Type = DockLayoutNode::Area;
+	Node.CurrentDockWidget = s.attributes().value("Current").toString();
+	const auto AllowedAreasAttribute = s.attributes().value("AllowedAreas");
+	if (!AllowedAreasAttribute.isEmpty())
+	{
+		Node.AllowedAreas = AllowedAreasAttribute.toInt(nullptr, 16);
+	}
+
+	const auto FlagsAttribute = s.attributes().value("Flags");
+	if (!FlagsAttribute.isEmpty())
+	{
+		Node.Flags = FlagsAttribute.toInt(nullptr, 16);
+	}
+
+	while (s.readNextStartElement())
+	{
+		if (s.name() != QLatin1String("Widget"))
+		{
+			s.skipCurrentElement();
+			continue;
+		}
+
+		DockLayoutWidget Widget;
+		Widget.Name = s.attributes().value("Name").toString();
+		if (Widget.Name.isEmpty())
+		{
+			return false;
+		}
+
+		Widget.Closed = s.attributes().value("Closed").toInt(&Ok);
+		if (!Ok)
+		{
+			return false;
+		}
+
+		s.skipCurrentElement();
+		Node.DockWidgets.append(Widget);
+	}
+
+	return true;
+}
+
+
+//============================================================================
+static bool readXmlNode(CDockingStateReader& s, DockLayoutNode& Node)
+{
+	if (s.name() == QLatin1String("Splitter"))
+	{
+		return readXmlSplitter(s, Node);
+	}
+	else
+	{
+		return readXmlArea(s, Node);
+	}
+}
+
+
+//============================================================================
+static bool readXmlContainer(CDockingStateReader& s, DockLayoutContainer& Container)
+{
+	Container.Floating = s.attributes().value("Floating").toInt();
+	if (Container.Floating)
+	{
+		if (!s.readNextStartElement() || s.name() != QLatin1String("Geometry"))
+		{
+			return false;
+		}
+
+		QByteArray GeometryString = s.readElementText(CDockingStateReader::ErrorOnUnexpectedElement).toLocal8Bit();
+		Container.Geometry = QByteArray::fromHex(GeometryString);
+		if (Container.Geometry.isEmpty())
+		{
+			return false;
+		}
+	}
+
+	while (s.readNextStartElement())
+	{
+		if (s.name() != QLatin1String("Splitter") && s.name() != QLatin1String("Area"))
+		{
+			s.skipCurrentElement();
+			continue;
+		}
+
+		Container.Root = DockLayoutNode();
+		if (!readXmlNode(s, Container.Root))
+		{
+			return false;
+		}
+		Container.HasRoot = true;
+	}
+
+	// The root of a container is always a splitter
+	return !Container.HasRoot || Container.Root.Type == DockLayoutNode::Splitter;
+}
+
+
+//============================================================================
+static void writeBinaryNode(QDataStream& s, const DockLayoutNode& Node)
+{
+	s << quint8(Node.Type);
+	if (Node.Type == DockLayoutNode::Splitter)
+	{
+		s << quint8(Node.Orientation == Qt::Horizontal ? 1 : 0);
+		s << qint32(Node.Sizes.count());
+		for (auto Size : Node.Sizes)
+		{
+			s << qint32(Size);
+		}
+		s << qint32(Node.Children.count());
+		for (const auto& Child : Node.Children)
+		{
+			writeBinaryNode(s, Child);
+		}
+	}
+	else
+	{
+		s << Node.CurrentDockWidget << qint32(Node.AllowedAreas) << qint32(Node.Flags);
+		s << qint32(Node.DockWidgets.count());
+		for (const auto& Widget : Node.DockWidgets)
+		{
+			s << Widget.Name << Widget.Closed;
+		}
+	}
+}
+
+
+//============================================================================
+/**
+ * Reads an element count. Every element takes at least one byte, so a count
+ * larger than the remaining data is invalid - this protects against huge
+ * allocations from corrupted data
+ */
+static bool readBinaryCount(QDataStream& s, int& Count)
+{
+	qint32 Value;
+	s >> Value;
+	if (s.status() != QDataStream::Ok || Value < 0 || Value > s.device()->bytesAvailable())
+	{
+		return false;
+	}
+	Count = Value;
+	return true;
+}
+
+
+//============================================================================
+static bool readBinaryNode(QDataStream& s, DockLayoutNode& Node)
+{
+	quint8 Type;
+	s >> Type;
+	if (Type == DockLayoutNode::Splitter)
+	{
+		Node.Type = DockLayoutNode::Splitter;
+		quint8 Horizontal;
+		s >> Horizontal;
+		Node.Orientation = Horizontal ? Qt::Horizontal : Qt::Vertical;
+		int Count;
+		if (!readBinaryCount(s, Count))
+		{
+			return false;
+		}
+		for (int i = 0; i < Count; ++i)
+		{
+			qint32 Size;
+			s >> Size;
+			Node.Sizes.append(Size);
+		}
+		if (!readBinaryCount(s, Count))
+		{
+			return false;
+		}
+		for (int i = 0; i < Count; ++i)
+		{
+			DockLayoutNode Child;
+			if (!readBinaryNode(s, Child))
+			{
+				return false;
+			}
+			Node.Children.append(Child);
+		}
+	}
+	else if (Type == DockLayoutNode::Area)
+	{
+		Node.Type = DockLayoutNode::Area;
+		qint32 AllowedAreas, Flags;
+		s >> Node.CurrentDockWidget >> AllowedAreas >> Flags;
+		Node.AllowedAreas = AllowedAreas;
+		Node.Flags = Flags;
+		int Count;
+		if (!readBinaryCount(s, Count))
+		{
+			return false;
+		}
+		for (int i = 0; i < Count; ++i)
+		{
+			DockLayoutWidget Widget;
+			s >> Widget.Name >> Widget.Closed;
+			if (Widget.Name.isEmpty())
+			{
+				return false;
+			}
+			Node.DockWidgets.append(Widget);
+		}
+	}
+	else
+	{
+		return false;
+	}
+
+	return s.status() == QDataStream::Ok;
+}
+
+
+//============================================================================
+bool DockLayoutState::isBinary(const QByteArray& State)
+{
+	if (State.size() < int(sizeof(BinaryMagic)))
+	{
+		return false;
+	}
+	QDataStream s(State);
+	quint32 Magic;
+	s >> Magic;
+	return Magic == BinaryMagic;
+}
+
+
+//============================================================================
+bool DockLayoutState::fromByteArray(const QByteArray& State)
+{
+	*this = DockLayoutState();
+	if (State.isEmpty())
+	{
+		return false;
+	}
+
+	if (isBinary(State))
+	{
+		return fromBinary(State);
+	}
+
+	return fromXml(State.startsWith("<?xml") ? State : qUncompress(State));
+}
+
+
+//============================================================================
+bool DockLayoutState::fromXml(const QByteArray& State)
+{
+	if (State.isEmpty())
+	{
+		return false;
+	}
+
+	CDockingStateReader s(State);
+	s.readNextStartElement();
+	if (s.name() != QLatin1String("QtAdvancedDockingSystem"))
+	{
+		return false;
+	}
+
+	bool ok;
+	FileVersion = s.attributes().value("Version").toInt(&ok);
+	if (!ok)
+	{
+		return false;
+	}
+	s.setFileVersion(FileVersion);
+
+	// Older files do not support UserVersion but we still want to load them so
+	// we first test if the attribute exists
+	if (!s.attributes().value("UserVersion").isEmpty())
+	{
+		UserVersion = s.attributes().value("UserVersion").toInt(&ok);
+		if (!ok)
+		{
+			return false;
+		}
+		HasUserVersion = true;
+	}
+	CentralWidget = s.attributes().value("CentralWidget").toString();
+
+	while (s.readNextStartElement())
+	{
+		if (s.name() != QLatin1String("Container"))
+		{
+			s.skipCurrentElement();
+			continue;
+		}
+
+		DockLayoutContainer Container;
+		if (!readXmlContainer(s, Container))
+		{
+			return false;
+		}
+		Containers.append(Container);
+	}
+
+	return !s.hasError();
+}
+
+
+//============================================================================
+bool DockLayoutState::fromBinary(const QByteArray& State)
+{
+	QDataStream s(State);
+	s.setVersion(QDataStream::Qt_5_6);
+	quint32 Magic;
+	quint8 FormatVersion;
+	s >> Magic >> FormatVersion;
+	if (Magic != BinaryMagic || FormatVersion > BinaryFormatVersion)
+	{
+		return false;
+	}
+
+	qint32 Version;
+	s >> Version;
+	FileVersion = Version;
+	s >> Version;
+	UserVersion = Version;
+	HasUserVersion = true;
+	s >> CentralWidget;
+
+	int Count;
+	if (!readBinaryCount(s, Count))
+	{
+		return false;
+	}
+	for (int i = 0; i < Count; ++i)
+	{
+		DockLayoutContainer Container;
+		s >> Container.Floating >> Container.Geometry >> Container.HasRoot;
+		if (Container.Floating && Container.Geometry.isEmpty())
+		{
+			return false;
+		}
+		if (Container.HasRoot)
+		{
+			if (!readBinaryNode(s, Container.Root) || Container.Root.Type != DockLayoutNode::Splitter)
+			{
+				return false;
+			}
+		}
+		Containers.append(Container);
+	}
+
+	return s.status() == QDataStream::Ok;
+}
+
+
+//============================================================================
+QByteArray DockLayoutState::toBinary() const
+{
+	QByteArray Data;
+	QDataStream s(&Data, QIODevice::WriteOnly);
+	s.setVersion(QDataStream::Qt_5_6);
+	s << BinaryMagic << BinaryFormatVersion;
+	s << qint32(FileVersion) << qint32(UserVersion) << CentralWidget;
+	s << qint32(Containers.count());
+	for (const auto& Container : Containers)
+	{
+		s << Container.Floating << Container.Geometry << Container.HasRoot;
+		if (Container.HasRoot)
+		{
+			writeBinaryNode(s, Container.Root);
+		}
+	}
+	return Data;
+}
+} // namespace ads
+
+//---------------------------------------------------------------------------
+// EOF DockLayoutState.cpp
@@ -0,0 +1,106 @@
+#ifndef DockLayoutStateH
+#define DockLayoutStateH
+//============================================================================
+/// \file   DockLayoutState.h
+/// \date   18.10.2026
+/// \brief  Declaration of the in-memory dock layout tree
+//============================================================================
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+#include <QByteArray>
+#include <QList>
+#include <QString>
+
+namespace ads
+{
+/**
+ * A dock widget entry of a dock area in a saved layout
+ */
+struct DockLayoutWidget
+{
+	QString Name;
+	bool Closed = false;
+};
+
+
+/**
+ * A node of a saved layout - either a splitter or a dock area
+ */
+struct DockLayoutNode
+{
+	enum eType
+	{
+		Splitter,
+		Area
+	};
+
+	eType Type = Splitter;
+
+	// Splitter data
+	Qt::Orientation Orientation = Qt::Horizontal;
+	QList<int> Sizes;
+	QList<DockLayoutNode> Children;
+
+	// Dock area data - AllowedAreas and Flags are -1 if the area uses the
+	// default values
+	QString CurrentDockWidget;
+	int AllowedAreas = -1;
+	int Flags = -1;
+	QList<DockLayoutWidget> DockWidgets;
+};
+
+
+/**
+ * A dock container (the dock manager itself or a floating widget) in a
+ * saved layout
+ */
+struct DockLayoutContainer
+{
+	bool Floating = false;
+	QByteArray Geometry;
+	bool HasRoot = false;
+	DockLayoutNode Root;
+};
+
+
+/**
+ * The complete saved state of a dock manager.
+ * The state is parsed and validated in a single pass into this tree and
+ * then applied, so a broken state never modifies the dock manager.
+ * Besides the XML format written by CDockManager::saveState() the tree
+ * can be stored in a compact binary format.
+ */
+struct DockLayoutState
+{
+	int FileVersion = 0;
+	bool HasUserVersion = false;
+	int UserVersion = 0;
+	QString CentralWidget;
+	QList<DockLayoutContainer> Containers;
+
+	/**
+	 * Parses the given state. The state may be XML, compressed XML or the
+	 * binary format. Returns false if the data is not a valid layout.
+	 */
+	bool fromByteArray(const QByteArray& State);
+
+	/**
+	 * Returns the layout in the compact binary format
+	 */
+	QByteArray toBinary() const;
+
+	/**
+	 * Returns true if the given data is in the binary format
+	 */
+	static bool isBinary(const QByteArray& State);
+
+private:
+	bool fromXml(const QByteArray& State);
+	bool fromBinary(const QByteArray& State);
+};
+} // namespace ads
+
+//---------------------------------------------------------------------------
+#endif // DockLayoutStateH
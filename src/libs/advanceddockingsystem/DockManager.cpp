@@ -32,6 +32,7 @@
 #include "DockManager.h"
 
 #include <algorithm>
+#include <functional>
 #include <iostream>
 
 #include <QMainWindow>
@@ -52,7 +53,7 @@
 #include "ads_globals.h"
 #include "DockAreaWidget.h"
 #include "IconProvider.h"
-#include "DockingStateReader.h"
+#include "DockLayoutState.h"
 #include "DockAreaTitleBar.h"
 #include "DockFocusController.h"
 #include "DockSplitter.h"
@@ -118,21 +119,45 @@ struct DockManagerPrivate
 	DockManagerPrivate(CDockManager* _public);
 
 	/**
-	 * Checks if the given data stream is a valid docking system state
-	 * file.
+	 * Parses the given state into the layout tree and checks if it is a
+	 * valid docking system state for this dock manager.
 	 */
-	bool checkFormat(const QByteArray &state, int version);
+	bool parseState(const QByteArray &state, int version, DockLayoutState& Layout);
 
 	/**
-	 * Restores the state
+	 * Restores the state from a parsed and validated layout tree
 	 */
-	bool restoreStateFromXml(const QByteArray &state, int version, bool Testing = internal::Restore);
+	void restoreLayout(const DockLayoutState& Layout);
+
+	/**
+	 * Returns true if the layout tree has the same containers, splitters
+	 * and dock areas as the current layout
+	 */
+	bool hasSameStructure(const DockLayoutState& Layout) const;
+
+	/**
+	 * Applies a layout tree with the same structure in place without
+	 * rebuilding the splitters and dock areas
+	 */
+	void applyLayout(const DockLayoutState& Layout);
 
 	/**
 	 * Restore state
 	 */
 	bool restoreState(const QByteArray &state, int version);
 
+	/**
+	 * Restores the state from an already parsed and validated layout tree
+	 */
+	void restoreState(const DockLayoutState& Layout);
+
+	/**
+	 * Hides the dock manager and sets the RestoringState flag while the
+	 * given function restores the state. Emits restoringState() before and
+	 * stateRestored() after the restore.
+	 */
+	bool restoreStateHidden(const std::function<bool()>& Restore);
+
 	void restoreDockWidgetsOpenState();
 	void restoreDockAreasIndices();
 	void emitTopLevelEvents();
@@ -157,7 +182,7 @@ struct DockManagerPrivate
 	/**
 	 * Restores the container with the given index
 	 */
-	bool restoreContainer(int Index, CDockingStateReader& stream, bool Testing);
+	bool restoreContainer(int Index, const DockLayoutContainer& Layout);
 
 	/**
 	 * Loads the stylesheet
@@ -201,18 +226,13 @@ void DockManagerPrivate::loadStylesheet()
 
 
 //============================================================================
-bool DockManagerPrivate::restoreContainer(int Index, CDockingStateReader& stream, bool Testing)
+bool DockManagerPrivate::restoreContainer(int Index, const DockLayoutContainer& Layout)
 {
-	if (Testing)
-	{
-		Index = 0;
-	}
-
 	bool Result = false;
 	if (Index >= Containers.count())
 	{
 		CFloatingDockContainer* FloatingWidget = new CFloatingDockContainer(_this);
-		Result = FloatingWidget->restoreState(stream, Testing);
+		Result = FloatingWidget->restoreState(Layout);
 	}
 	else
 	{
@@ -220,11 +240,11 @@ bool DockManagerPrivate::restoreContainer(int Index, CDockingStateReader& stream
 		auto Container = Containers[Index];
 		if (Container->isFloating())
 		{
-			Result = Container->floatingWidget()->restoreState(stream, Testing);
+			Result = Container->floatingWidget()->restoreState(Layout);
 		}
 		else
 		{
-			Result = Container->restoreState(stream, Testing);
+			Result = Container->restoreState(Layout);
 		}
 	}
 
@@ -233,61 +253,35 @@ bool DockManagerPrivate::restoreContainer(int Index, CDockingStateReader& stream
 
 
 //============================================================================
-bool DockManagerPrivate::checkFormat(const QByteArray &state, int version)
+bool DockManagerPrivate::parseState(const QByteArray &state, int version,
+	DockLayoutState& Layout)
 {
-    return restoreStateFromXml(state, version, internal::RestoreTesting);
-}
-
-
-//============================================================================
-bool DockManagerPrivate::restoreStateFromXml(const QByteArray &state,  int version,
-	bool Testing)
-{
-	Q_UNUSED(version);
+	// The state is parsed only once - the layout tree is validated here and
+	// then applied without parsing the data again
+	if (!Layout.fromByteArray(state))
+	{
+		return false;
+	}
 
-    if (state.isEmpty())
-    {
-        return false;
-    }
-    CDockingStateReader s(state);
-    s.readNextStartElement();
-    if (s.name() != QLatin1String("QtAdvancedDockingSystem"))
+    ADS_PRINT(Layout.FileVersion);
+    if (Layout.FileVersion > CurrentVersion)
     {
     	return false;
     }
-    ADS_PRINT(s.attributes().value("Version"));
-    bool ok;
-    int v = s.attributes().value("Version").toInt(&ok);
-    if (!ok || v > CurrentVersion)
-    {
-    	return false;
-    }
-    s.setFileVersion(v);
 
-    ADS_PRINT(s.attributes().value("UserVersion"));
-    // Older files do not support UserVersion but we still want to load them so
-    // we first test if the attribute exists
-    if (!s.attributes().value("UserVersion").isEmpty())
+    ADS_PRINT(Layout.UserVersion);
+    // Older files do not support UserVersion but we still want to load them
+    if (Layout.HasUserVersion && Layout.UserVersion != version)
     {
-		v = s.attributes().value("UserVersion").toInt(&ok);
-		if (!ok || v != version)
-		{
-			return false;
-		}
+    	return false;
     }
 
-    bool Result = true;
-#ifdef ADS_DEBUG_PRINT
-    int  DockContainers = s.attributes().value("Containers").toInt();
-#endif
-    ADS_PRINT(DockContainers);
-
+    ADS_PRINT(Layout.Containers.count());
     if (CentralWidget)
     {
-		const auto CentralWidgetAttribute = s.attributes().value("CentralWidget");
 		// If we have a central widget but a state without central widget, then
 		// something is wrong.
-		if (CentralWidgetAttribute.isEmpty())
+		if (Layout.CentralWidget.isEmpty())
 		{
 			qWarning() << "Dock manager has central widget but saved state does not have central widget.";
 			return false;
@@ -295,40 +289,64 @@ bool DockManagerPrivate::restoreStateFromXml(const QByteArray &state,  int versi
 
 		// If the object name of the central widget does not match the name of the
 		// saved central widget, the something is wrong
-		if (CentralWidget->objectName() != CentralWidgetAttribute.toString())
+		if (CentralWidget->objectName() != Layout.CentralWidget)
 		{
 			qWarning() << "Object name of central widget does not match name of central widget in saved state.";
 			return false;
 		}
     }
 
+    return true;
+}
+
+
+//============================================================================
+void DockManagerPrivate::restoreLayout(const DockLayoutState& Layout)
+{
     int DockContainerCount = 0;
-    while (s.readNextStartElement())
+    for (const auto& Container : Layout.Containers)
     {
-        if (s.name() == QLatin1String("Container"))
-    	{
-    		Result = restoreContainer(DockContainerCount, s, Testing);
-			if (!Result)
-			{
-				break;
-			}
-			DockContainerCount++;
-    	}
+		restoreContainer(DockContainerCount, Container);
+		DockContainerCount++;
     }
 
-    if (!Testing)
-    {
-		// Delete remaining empty floating widgets
-		int FloatingWidgetIndex = DockContainerCount - 1;
-		for (int i = FloatingWidgetIndex; i < FloatingWidgets.count(); ++i)
+	// Delete remaining empty floating widgets
+	int FloatingWidgetIndex = DockContainerCount - 1;
+	for (int i = FloatingWidgetIndex; i < FloatingWidgets.count(); ++i)
+	{
+		auto* floatingWidget = FloatingWidgets[i];
+		_this->removeDockContainer(floatingWidget->dockContainer());
+		floatingWidget->deleteLater();
+	}
+}
+
+
+//============================================================================
+bool DockManagerPrivate::hasSameStructure(const DockLayoutState& Layout) const
+{
+	if (Layout.Containers.count() != Containers.count())
+	{
+		return false;
+	}
+
+	for (int i = 0; i < Containers.count(); ++i)
+	{
+		if (!Containers[i]->hasSameStructure(Layout.Containers[i]))
 		{
-			auto* floatingWidget = FloatingWidgets[i];
-			_this->removeDockContainer(floatingWidget->dockContainer());
-			floatingWidget->deleteLater();
+			return false;
 		}
-    }
+	}
+	return true;
+}
+
 
-    return Result;
+//============================================================================
+void DockManagerPrivate::applyLayout(const DockLayoutState& Layout)
+{
+	for (int i = 0; i < Containers.count(); ++i)
+	{
+		Containers[i]->applyState(Layout.Containers[i]);
+	}
 }
 
 
@@ -421,29 +439,59 @@ void DockManagerPrivate::emitTopLevelEvents()
 //============================================================================
 bool DockManagerPrivate::restoreState(const QByteArray& State, int version)
 {
-	QByteArray state = State.startsWith("<?xml") ? State : qUncompress(State);
-    if (!checkFormat(state, version))
+	DockLayoutState Layout;
+    if (!parseState(State, version, Layout))
     {
-        ADS_PRINT("checkFormat: Error checking format!!!!!!!");
+        ADS_PRINT("parseState: Error checking format!!!!!!!");
     	return false;
     }
 
+    restoreState(Layout);
+    return true;
+}
+
+
+//============================================================================
+void DockManagerPrivate::restoreState(const DockLayoutState& Layout)
+{
     // Hide updates of floating widgets from use
     hideFloatingWidgets();
     markDockWidgetsDirty();
-
-    if (!restoreStateFromXml(state, version))
-    {
-        ADS_PRINT("restoreState: Error restoring state!!!!!!!");
-    	return false;
-    }
+    restoreLayout(Layout);
 
     restoreDockWidgetsOpenState();
     restoreDockAreasIndices();
     emitTopLevelEvents();
     _this->dumpLayout();
+}
 
-    return true;
+
+//============================================================================
+bool DockManagerPrivate::restoreStateHidden(const std::function<bool()>& Restore)
+{
+	// We hide the complete dock manager here. Restoring the state means
+	// that DockWidgets are removed from the DockArea internal stack layout
+	// which in turn  means, that each time a widget is removed the stack
+	// will show and raise the next available widget which in turn
+	// triggers show events for the dock widgets. To avoid this we hide the
+	// dock manager. Because there will be no processing of application
+	// events until this function is finished, the user will not see this
+	// hiding
+	bool IsHidden = _this->isHidden();
+	if (!IsHidden)
+	{
+		_this->hide();
+	}
+	RestoringState = true;
+	Q_EMIT _this->restoringState();
+	bool Result = Restore();
+	RestoringState = false;
+	if (!IsHidden)
+	{
+		_this->show();
+	}
+	Q_EMIT _this->stateRestored();
+	return Result;
 }
 
 
@@ -664,9 +712,28 @@ unsigned int CDockManager::zOrderIndex() const
 //============================================================================
 QByteArray CDockManager::saveState(int version) const
 {
+    auto ConfigFlags = CDockManager::configFlags();
+    if (ConfigFlags.testFlag(BinaryStateFormat))
+    {
+    	DockLayoutState Layout;
+    	Layout.FileVersion = CurrentVersion;
+    	Layout.HasUserVersion = true;
+    	Layout.UserVersion = version;
+    	if (d->CentralWidget)
+    	{
+    		Layout.CentralWidget = d->CentralWidget->objectName();
+    	}
+    	for (auto Container : d->Containers)
+    	{
+    		DockLayoutContainer ContainerLayout;
+    		Container->saveState(ContainerLayout);
+    		Layout.Containers.append(ContainerLayout);
+    	}
+    	return Layout.toBinary();
+    }
+
     QByteArray xmldata;
     QXmlStreamWriter s(&xmldata);
-    auto ConfigFlags = CDockManager::configFlags();
 	s.setAutoFormatting(ConfigFlags.testFlag(XmlAutoFormattingEnabled));
     s.writeStartDocument();
 		s.writeStartElement("QtAdvancedDockingSystem");
@@ -700,29 +767,10 @@ bool CDockManager::restoreState(const QByteArray &state, int version)
 		return false;
 	}
 
-	// We hide the complete dock manager here. Restoring the state means
-	// that DockWidgets are removed from the DockArea internal stack layout
-	// which in turn  means, that each time a widget is removed the stack
-	// will show and raise the next available widget which in turn
-	// triggers show events for the dock widgets. To avoid this we hide the
-	// dock manager. Because there will be no processing of application
-	// events until this function is finished, the user will not see this
-	// hiding
-	bool IsHidden = this->isHidden();
-	if (!IsHidden)
-	{
-		hide();
-	}
-	d->RestoringState = true;
-	Q_EMIT restoringState();
-	bool Result = d->restoreState(state, version);
-	d->RestoringState = false;
-	if (!IsHidden)
-	{
-		show();
-	}
-	Q_EMIT stateRestored();
-	return Result;
+	return d->restoreStateHidden([this, &state, version]()
+		{
+			return d->restoreState(state, version);
+		});
 }
 
 
@@ -924,7 +972,36 @@ void CDockManager::openPerspective(const QString& PerspectiveName)
 	}
 
 	Q_EMIT openingPerspective(PerspectiveName);
-	restoreState(Iterator.value());
+	// Perspectives often differ only in splitter sizes or in the dock widgets
+	// that are open. If the perspective has the same splitters and dock
+	// areas as the current layout, we apply the differences in place instead
+	// of hiding the dock manager and rebuilding the complete layout
+	// The layout is parsed only once - if the structure differs, the parsed
+	// layout is restored completely
+	DockLayoutState Layout;
+	if (!d->RestoringState && d->parseState(Iterator.value(), 0, Layout))
+	{
+		if (d->hasSameStructure(Layout))
+		{
+			d->RestoringState = true;
+			Q_EMIT restoringState();
+			d->applyLayout(Layout);
+			d->RestoringState = false;
+			Q_EMIT stateRestored();
+		}
+		else
+		{
+			d->restoreStateHidden([this, &Layout]()
+				{
+					d->restoreState(Layout);
+					return true;
+				});
+		}
+	}
+	else
+	{
+		restoreState(Iterator.value());
+	}
 	Q_EMIT perspectiveOpened(PerspectiveName);
 }
 
@@ -201,6 +201,7 @@ public:
 														 //!< If neither this nor FloatingContainerForceNativeTitleBar is set (the default) native titlebars are used except on known bad systems.
 														 //! Users can overwrite this by setting the environment variable ADS_UseNativeTitle to "1" or "0".
 		MiddleMouseButtonClosesTab = 0x2000000, //! If the flag is set, the user can use the mouse middle button to close the tab under the mouse
+		BinaryStateFormat = 0x4000000, //!< If enabled, saveState() writes a compact binary layout instead of XML - restoreState() accepts both formats
 
         DefaultDockAreaButtons = DockAreaHasCloseButton
 							   | DockAreaHasUndockButton
@@ -348,6 +349,8 @@ public:
 	 * The XmlMode XmlAutoFormattingDisabled is better if you would like to have
 	 * a more compact XML output - i.e. for storage in ini files.
 	 * The version number is stored as part of the data.
+	 * If the BinaryStateFormat flag is set, the state is stored in a compact
+	 * binary format instead of XML.
 	 * To restore the saved state, pass the return value and version number
 	 * to restoreState().
 	 * \see restoreState()
@@ -360,6 +363,9 @@ public:
 	 * not match, the dockmanager's state is left unchanged, and this function
 	 * returns false; otherwise, the state is restored, and this function
 	 * returns true.
+	 * The state is parsed and validated once into an in-memory layout tree
+	 * before anything is modified, so a corrupted state also leaves the
+	 * dock manager unchanged.
 	 * \see saveState()
 	 */
 	bool restoreState(const QByteArray &state, int version = 0);
@@ -522,6 +528,10 @@ public:
 public Q_SLOTS:
 	/**
 	 * Opens the perspective with the given name.
+	 * If the perspective has the same splitters and dock areas as the
+	 * current layout, only the open dock widgets, the current tabs, the
+	 * splitter sizes and the floating widget geometries are changed in
+	 * place. Otherwise the complete layout is restored via restoreState().
 	 */
 	void openPerspective(const QString& PerspectiveName);
 
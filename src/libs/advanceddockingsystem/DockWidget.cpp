@@ -44,6 +44,7 @@
 #include <QDebug>
 #include <QToolBar>
 #include <QXmlStreamWriter>
+#include <QTimer>
 #include <QWindow>
 
 #include <QGuiApplication>
@@ -91,6 +92,8 @@ struct DockWidgetPrivate
 	QList<QAction*> TitleBarActions;
 	CDockWidget::eMinimumSizeHintMode MinimumSizeHintMode = CDockWidget::MinimumSizeHintFromDockWidget;
 	WidgetFactory* Factory = nullptr;
+	int ContentDeleteDelay = 0;
+	QTimer* ContentDeleteTimer = nullptr;
 	
 	/**
 	 * Private data constructor
@@ -129,6 +132,23 @@ struct DockWidgetPrivate
 	 * returns true on success.
 	 */
 	bool createWidgetFromFactory();
+
+	/**
+	 * Creates the content widget if a widget factory is registered and the
+	 * content has not been created yet or has been deleted on close
+	 */
+	void ensureWidget();
+
+	/**
+	 * Deletes the content widget together with the scroll area that wraps it
+	 */
+	void deleteContent();
+
+	/**
+	 * Deletes the content on close if the DeleteContentOnClose feature is
+	 * set - immediately or after the configured content delete delay
+	 */
+	void scheduleDeleteContent();
 };
 // struct DockWidgetPrivate
 
@@ -143,6 +163,11 @@ DockWidgetPrivate::DockWidgetPrivate(CDockWidget* _public) :
 //============================================================================
 void DockWidgetPrivate::showDockWidget()
 {
+	if (ContentDeleteTimer)
+	{
+		ContentDeleteTimer->stop();
+	}
+
 	if (!Widget)
 	{
 		if (!createWidgetFromFactory())
@@ -191,12 +216,7 @@ void DockWidgetPrivate::hideDockWidget()
 {
 	TabWidget->hide();
 	updateParentDockArea();
-	
-	if (Features.testFlag(CDockWidget::DeleteContentOnClose))
-	{
-		Widget->deleteLater();
-		Widget = nullptr;
-	}
+	scheduleDeleteContent();
 }
 
 
@@ -253,11 +273,6 @@ void DockWidgetPrivate::setupScrollArea()
 //============================================================================
 bool DockWidgetPrivate::createWidgetFromFactory()
 {
-	if (!Features.testFlag(CDockWidget::DeleteContentOnClose)) 
-	{
-		return false;
-	}
-	
 	if (!Factory)
 	{
 		return false;
@@ -274,6 +289,62 @@ bool DockWidgetPrivate::createWidgetFromFactory()
 }
 
 
+//============================================================================
+void DockWidgetPrivate::ensureWidget()
+{
+	if (!Widget && Factory)
+	{
+		createWidgetFromFactory();
+	}
+}
+
+
+//============================================================================
+void DockWidgetPrivate::deleteContent()
+{
+	if (!Widget)
+	{
+		return;
+	}
+
+	// takeWidget() also removes the scroll area, otherwise the content
+	// created by the factory the next time would get a second scroll area
+	QWidget* w = _this->takeWidget();
+	w->deleteLater();
+}
+
+
+//============================================================================
+void DockWidgetPrivate::scheduleDeleteContent()
+{
+	if (!Widget || !Features.testFlag(CDockWidget::DeleteContentOnClose))
+	{
+		return;
+	}
+
+	if (ContentDeleteDelay <= 0)
+	{
+		deleteContent();
+		return;
+	}
+
+	if (!ContentDeleteTimer)
+	{
+		ContentDeleteTimer = new QTimer(_this);
+		ContentDeleteTimer->setSingleShot(true);
+		QObject::connect(ContentDeleteTimer, &QTimer::timeout, _this, [this]()
+		{
+			// the dock widget may have been reopened in the meantime
+			if (Closed)
+			{
+				deleteContent();
+			}
+		});
+	}
+	ContentDeleteTimer->start(ContentDeleteDelay);
+}
+
+
 //============================================================================
 CDockWidget::CDockWidget(const QString &title, QWidget *parent) :
 	QFrame(parent),
@@ -353,6 +424,33 @@ void CDockWidget::setWidgetFactory(FactoryFunc createWidget, eInsertMode insertM
 	}
 
 	d->Factory = new DockWidgetPrivate::WidgetFactory { createWidget, insertMode };
+	// A visible dock widget creates its content right away, all other dock
+	// widgets create it the first time they become visible
+	if (isVisible())
+	{
+		d->ensureWidget();
+	}
+}
+
+
+//============================================================================
+bool CDockWidget::hasWidgetFactory() const
+{
+	return d->Factory != nullptr;
+}
+
+
+//============================================================================
+void CDockWidget::setContentDeleteDelay(int Milliseconds)
+{
+	d->ContentDeleteDelay = Milliseconds;
+}
+
+
+//============================================================================
+int CDockWidget::contentDeleteDelay() const
+{
+	return d->ContentDeleteDelay;
 }
 
 
@@ -652,6 +750,9 @@ bool CDockWidget::event(QEvent *e)
 		break;
 
 	case QEvent::Show:
+		// The widget factory runs the first time the dock widget becomes
+		// visible, e.g. when its tab becomes the current tab
+		d->ensureWidget();
 		Q_EMIT visibilityChanged(geometry().right() >= 0 && geometry().bottom() >= 0);
         break;
 
@@ -272,16 +272,42 @@ public:
     void setWidget(QWidget* widget, eInsertMode InsertMode = AutoScrollArea);
 	
 	/**
-	 * Only used when the feature flag DeleteContentOnClose is set.
-	 * Using the flag and setting a widget factory allows to free the resources
-	 * of the widget of your application while retaining the position the next
-	 * time you want to show your widget, unlike the flag DockWidgetDeleteOnClose
-	 * which deletes the dock widget itself. Since we keep the dock widget, all
-	 * regular features of ADS should work as normal, including saving and
-	 * restoring the state of the docking system and using perspectives.
+	 * Sets a factory that creates the content widget on demand.
+	 * If no widget has been set, the factory is called the first time the
+	 * dock widget becomes visible, i.e. when it is shown or when its tab
+	 * becomes the current tab. Dock widgets that are registered but never
+	 * shown do not create their content at all.
+	 * Together with the feature flag DeleteContentOnClose, the content is
+	 * deleted when the dock widget is closed and the factory rebuilds it the
+	 * next time it is shown. This allows to free the resources of the
+	 * widget of your application while retaining the position, unlike the
+	 * flag DockWidgetDeleteOnClose which deletes the dock widget itself.
+	 * Since we keep the dock widget, all regular features of ADS should work
+	 * as normal, including saving and restoring the state of the docking
+	 * system and using perspectives.
 	 */
 	using FactoryFunc = std::function<QWidget*(QWidget*)>;
 	void setWidgetFactory(FactoryFunc createWidget, eInsertMode InsertMode = AutoScrollArea);
+
+	/**
+	 * Returns true, if a widget factory has been set
+	 */
+	bool hasWidgetFactory() const;
+
+	/**
+	 * Only used when the feature flag DeleteContentOnClose is set.
+	 * Sets the time in milliseconds the dock widget needs to stay closed
+	 * before its content is deleted. If the dock widget is opened again
+	 * within this time, the existing content is reused. The default value
+	 * 0 deletes the content immediately on close.
+	 */
+	void setContentDeleteDelay(int Milliseconds);
+
+	/**
+	 * Returns the content delete delay in milliseconds.
+	 * \see setContentDeleteDelay()
+	 */
+	int contentDeleteDelay() const;
 	
     /**
      * Remove the widget from the dock and give ownership back to the caller
@@ -290,7 +316,8 @@ public:
 
     /**
      * Returns the widget for the dock widget. This function returns zero if
-     * the widget has not been set.
+     * the widget has not been set or if the widget factory has not created
+     * the content yet.
      */
     QWidget* widget() const;
 
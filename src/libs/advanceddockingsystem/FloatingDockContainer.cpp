@@ -45,6 +45,8 @@
 #include "DockManager.h"
 #include "DockWidget.h"
 #include "DockOverlay.h"
+#include "DockDropTargetIndex.h"
+#include "DockLayoutState.h"
 
 #ifdef Q_OS_WIN
 #include <windows.h>
@@ -370,6 +372,7 @@ struct FloatingDockContainerPrivate
 	eDragState DraggingState = DraggingInactive;
 	QPoint DragStartMousePosition;
 	CDockContainerWidget *DropContainer = nullptr;
+	CDockDropTargetIndex *DropTargets = nullptr;
 	CDockAreaWidget *SingleDockArea = nullptr;
 	QPoint DragStartPos;
 	bool Hiding = false;
@@ -406,6 +409,12 @@ struct FloatingDockContainerPrivate
 
 	void setState(eDragState StateId)
 	{
+		// The layout may have changed since the last drag operation, so the
+		// drop targets are captured again for each drag
+		if (DropTargets && StateId != DraggingState)
+		{
+			DropTargets->invalidate();
+		}
 		DraggingState = StateId;
 	}
 
@@ -515,29 +524,13 @@ void FloatingDockContainerPrivate::updateDropOverlays(const QPoint &GlobalPos)
 		return;
 	}
 
-	auto Containers = DockManager->dockContainers();
-	CDockContainerWidget *TopContainer = nullptr;
-	for (auto ContainerWidget : Containers)
+	if (!DropTargets)
 	{
-		if (!ContainerWidget->isVisible())
-		{
-			continue;
-		}
-
-		if (DockContainer == ContainerWidget)
-		{
-			continue;
-		}
-
-		QPoint MappedPos = ContainerWidget->mapFromGlobal(GlobalPos);
-		if (ContainerWidget->rect().contains(MappedPos))
-		{
-			if (!TopContainer || ContainerWidget->isInFrontOf(TopContainer))
-			{
-				TopContainer = ContainerWidget;
-			}
-		}
+		DropTargets = new CDockDropTargetIndex(DockManager, _this);
+		DropTargets->setExcludedContainer(DockContainer);
 	}
+	auto Hit = DropTargets->hitTest(GlobalPos);
+	CDockContainerWidget *TopContainer = Hit.Container;
 
 	DropContainer = TopContainer;
 	auto ContainerOverlay = DockManager->containerOverlay();
@@ -550,13 +543,13 @@ void FloatingDockContainerPrivate::updateDropOverlays(const QPoint &GlobalPos)
 		return;
 	}
 
-	int VisibleDockAreas = TopContainer->visibleDockAreaCount();
+	int VisibleDockAreas = Hit.VisibleDockAreas;
 	ContainerOverlay->setAllowedAreas(
 	    VisibleDockAreas > 1 ? OuterDockAreas : AllDockAreas);
 	DockWidgetArea ContainerArea = ContainerOverlay->showOverlay(TopContainer);
 	ContainerOverlay->enableDropPreview(ContainerArea != InvalidDockWidgetArea);
-	auto DockArea = TopContainer->dockAreaAt(GlobalPos);
-	if (DockArea && DockArea->isVisible() && VisibleDockAreas > 0)
+	auto DockArea = Hit.DockArea;
+	if (DockArea && VisibleDockAreas > 0)
 	{
 		DockAreaOverlay->enableDropPreview(true);
 		DockAreaOverlay->setAllowedAreas(
@@ -1003,10 +996,9 @@ void CFloatingDockContainer::onDockAreaCurrentChanged(int Index)
 }
 
 //============================================================================
-bool CFloatingDockContainer::restoreState(CDockingStateReader &Stream,
-    bool Testing)
+bool CFloatingDockContainer::restoreState(const DockLayoutContainer& Layout)
 {
-	if (!d->DockContainer->restoreState(Stream, Testing))
+	if (!d->DockContainer->restoreState(Layout))
 	{
 		return false;
 	}
@@ -1246,7 +1238,7 @@ void CFloatingDockContainer::moveEvent(QMoveEvent *event)
 	Super::moveEvent(event);
 	if (!d->IsResizing && event->spontaneous())
 	{
-		d->DraggingState = DraggingFloatingWidget;
+		d->setState(DraggingFloatingWidget);
 		d->updateDropOverlays(QCursor::pos());
 	}
 	d->IsResizing = false;
@@ -21,6 +21,7 @@
 #include "DockManager.h"
 #include "DockContainerWidget.h"
 #include "DockOverlay.h"
+#include "DockDropTargetIndex.h"
 
 namespace ads
 {
@@ -36,6 +37,7 @@ struct FloatingDragPreviewPrivate
 	QPoint DragStartMousePosition;
 	CDockManager* DockManager;
 	CDockContainerWidget *DropContainer = nullptr;
+	CDockDropTargetIndex* DropTargets = nullptr;
 	qreal WindowOpacity;
 	bool Hidden = false;
 	QPixmap ContentPreviewPixmap;
@@ -83,24 +85,15 @@ void FloatingDragPreviewPrivate::updateDropOverlays(const QPoint &GlobalPos)
 		return;
 	}
 
-	auto Containers = DockManager->dockContainers();
-	CDockContainerWidget *TopContainer = nullptr;
-	for (auto ContainerWidget : Containers)
+	// The drag preview lives for a single drag operation, so the drop
+	// target index is built with the first move and reused until the dock
+	// areas change
+	if (!DropTargets)
 	{
-		if (!ContainerWidget->isVisible())
-		{
-			continue;
-		}
-
-		QPoint MappedPos = ContainerWidget->mapFromGlobal(GlobalPos);
-		if (ContainerWidget->rect().contains(MappedPos))
-		{
-			if (!TopContainer || ContainerWidget->isInFrontOf(TopContainer))
-			{
-				TopContainer = ContainerWidget;
-			}
-		}
+		DropTargets = new CDockDropTargetIndex(DockManager, _this);
 	}
+	auto Hit = DropTargets->hitTest(GlobalPos);
+	CDockContainerWidget *TopContainer = Hit.Container;
 
 	DropContainer = TopContainer;
 	auto ContainerOverlay = DockManager->containerOverlay();
@@ -119,11 +112,11 @@ void FloatingDragPreviewPrivate::updateDropOverlays(const QPoint &GlobalPos)
 		return;
 	}
 
-	int VisibleDockAreas = TopContainer->visibleDockAreaCount();
+	int VisibleDockAreas = Hit.VisibleDockAreas;
 	ContainerOverlay->setAllowedAreas(
 	    VisibleDockAreas > 1 ? OuterDockAreas : AllDockAreas);
-	auto DockArea = TopContainer->dockAreaAt(GlobalPos);
-	if (DockArea && DockArea->isVisible() && VisibleDockAreas >= 0 && DockArea != ContentSourceArea)
+	auto DockArea = Hit.DockArea;
+	if (DockArea && VisibleDockAreas >= 0 && DockArea != ContentSourceArea)
 	{
 		DockAreaOverlay->enableDropPreview(true);
 		DockAreaOverlay->setAllowedAreas(
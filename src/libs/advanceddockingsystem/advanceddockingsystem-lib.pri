@@ -24,6 +24,8 @@ HEADERS += \
     $$PWD/DockWidget.h \
     $$PWD/DockWidgetTab.h \
     $$PWD/DockingStateReader.h \
+    $$PWD/DockLayoutState.h \
+    $$PWD/DockDropTargetIndex.h \
     $$PWD/FloatingDockContainer.h \
     $$PWD/FloatingDragPreview.h \
     $$PWD/DockOverlay.h \
@@ -44,6 +46,8 @@ SOURCES += \
         $$PWD/DockManager.cpp \
         $$PWD/DockWidget.cpp \
         $$PWD/DockingStateReader.cpp \
+        $$PWD/DockLayoutState.cpp \
+        $$PWD/DockDropTargetIndex.cpp \
         $$PWD/DockWidgetTab.cpp \
         $$PWD/FloatingDockContainer.cpp \
         $$PWD/FloatingDragPreview.cpp \
@@ -0,0 +1,211 @@
+#ifndef Test_DockDragH
+#define Test_DockDragH
+//============================================================================
+/// \file   Test_DockDrag.h
+/// \date   18.10.2026
+/// \brief  Drop target tests and frame time benchmark for dragging over a
+///         layout with many areas
+//============================================================================
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+#include <QtTest>
+#include <QCursor>
+#include <QElapsedTimer>
+#include <QLabel>
+#include <QScopedPointer>
+
+#include "DockManager.h"
+#include "DockContainerWidget.h"
+#include "DockAreaWidget.h"
+#include "DockDropTargetIndex.h"
+#include "DockWidget.h"
+#include "DockOverlay.h"
+#include "FloatingDragPreview.h"
+
+/**
+ * Checks the drop target index against a full scan of the containers and
+ * measures the time of one drag frame - moving the drag preview and updating
+ * the drop overlays - over a dock manager with 100 dock areas
+ */
+class Test_DockDrag : public QObject
+{
+	Q_OBJECT
+
+private:
+	static const int DockAreaCount = 100;
+	static const int FramesPerPass = 400;
+
+	QScopedPointer<ads::CDockManager> DockManager;
+	ads::CDockWidget* DraggedWidget = nullptr;
+
+	/**
+	 * Returns the cursor positions of one pass - a zig zag path over the
+	 * complete dock manager, so that the cursor crosses many dock areas
+	 */
+	QVector<QPoint> dragPath() const
+	{
+		QVector<QPoint> Path;
+		QRect Rect(DockManager->mapToGlobal(QPoint(0, 0)), DockManager->size());
+		Rect.adjust(5, 5, -5, -5);
+		for (int i = 0; i < FramesPerPass; ++i)
+		{
+			int Row = i * 10 / FramesPerPass;
+			double t = double(i % (FramesPerPass / 10)) / (FramesPerPass / 10);
+			int x = Rect.left() + int(((Row % 2) ? 1 - t : t) * Rect.width());
+			int y = Rect.top() + Row * Rect.height() / 10 + Rect.height() / 20;
+			Path.append(QPoint(x, y));
+		}
+		return Path;
+	}
+
+	/**
+	 * The drop target lookup the drag code used before the drop target index:
+	 * maps the position into every visible container, picks the front most
+	 * one and asks it for the dock area at the position
+	 */
+	ads::CDockDropTargetIndex::HitResult scanDropTarget(const QPoint& GlobalPos) const
+	{
+		ads::CDockDropTargetIndex::HitResult Result;
+		for (auto ContainerWidget : DockManager->dockContainers())
+		{
+			if (!ContainerWidget->isVisible())
+			{
+				continue;
+			}
+
+			QPoint MappedPos = ContainerWidget->mapFromGlobal(GlobalPos);
+			if (ContainerWidget->rect().contains(MappedPos))
+			{
+				if (!Result.Container || ContainerWidget->isInFrontOf(Result.Container))
+				{
+					Result.Container = ContainerWidget;
+				}
+			}
+		}
+
+		if (Result.Container)
+		{
+			Result.VisibleDockAreas = Result.Container->visibleDockAreaCount();
+			Result.DockArea = Result.Container->dockAreaAt(GlobalPos);
+		}
+		return Result;
+	}
+
+	/**
+	 * Compares the index with the full scan at every point of the drag path
+	 * and at a point outside of the dock manager
+	 */
+	void compareWithScan(ads::CDockDropTargetIndex& Index) const
+	{
+		QVector<QPoint> Path = dragPath();
+		Path.append(DockManager->mapToGlobal(QPoint(-20, -20)));
+		for (const QPoint& Pos : Path)
+		{
+			auto Expected = scanDropTarget(Pos);
+			auto Hit = Index.hitTest(Pos);
+			QCOMPARE(Hit.Container, Expected.Container);
+			QCOMPARE(Hit.DockArea, Expected.DockArea);
+			QCOMPARE(Hit.VisibleDockAreas, Expected.VisibleDockAreas);
+		}
+	}
+
+private Q_SLOTS:
+	void initTestCase()
+	{
+		DockManager.reset(new ads::CDockManager());
+		DockManager->resize(1600, 1000);
+
+		// Split the layout into a grid of 10 columns with 10 areas each
+		QList<ads::CDockAreaWidget*> Columns;
+		for (int i = 0; i < DockAreaCount; ++i)
+		{
+			auto DockWidget = new ads::CDockWidget(QString("Dock %1").arg(i));
+			DockWidget->setWidget(new QLabel(DockWidget->objectName()));
+			if (i < 10)
+			{
+				Columns.append(DockManager->addDockWidget(
+					Columns.isEmpty() ? ads::CenterDockWidgetArea : ads::RightDockWidgetArea,
+					DockWidget, Columns.isEmpty() ? nullptr : Columns.last()));
+			}
+			else
+			{
+				DockManager->addDockWidget(ads::BottomDockWidgetArea, DockWidget,
+					Columns.at(i % 10));
+			}
+			DraggedWidget = DockWidget;
+		}
+
+		DockManager->show();
+		QVERIFY(QTest::qWaitForWindowExposed(DockManager.data()));
+		QCOMPARE(DockManager->dockAreaCount(), DockAreaCount);
+	}
+
+	void cleanupTestCase()
+	{
+		DockManager.reset();
+	}
+
+	void hitTestMatchesScan()
+	{
+		ads::CDockDropTargetIndex Index(DockManager.data());
+		compareWithScan(Index);
+
+		// Hiding the only dock widget of an area hides the area. The index
+		// must notice this without being rebuilt explicitly
+		auto DockWidget = DockManager->findDockWidget("Dock 55");
+		QVERIFY(DockWidget);
+		auto DockArea = DockWidget->dockAreaWidget();
+		QPoint Center = DockArea->mapToGlobal(DockArea->rect().center());
+		QCOMPARE(Index.hitTest(Center).DockArea, DockArea);
+
+		DockWidget->toggleView(false);
+		QTest::qWait(50);
+		QVERIFY(DockArea->isHidden());
+		QVERIFY(Index.hitTest(Center).DockArea != DockArea);
+		compareWithScan(Index);
+
+		DockWidget->toggleView(true);
+		QTest::qWait(50);
+		QCOMPARE(Index.hitTest(Center).DockArea, DockArea);
+		compareWithScan(Index);
+	}
+
+	void dragFrameTime()
+	{
+		const QVector<QPoint> Path = dragPath();
+		QCursor::setPos(Path.first());
+		if (QCursor::pos() != Path.first())
+		{
+			QSKIP("the platform does not support moving the cursor");
+		}
+
+		auto Preview = new ads::CFloatingDragPreview(DraggedWidget);
+		Preview->startFloating(QPoint(10, 10), QSize(200, 100),
+			ads::DraggingFloatingWidget, nullptr);
+
+		qint64 Frames = 0;
+		QElapsedTimer Timer;
+		Timer.start();
+		QBENCHMARK
+		{
+			for (const QPoint& Pos : Path)
+			{
+				QCursor::setPos(Pos);
+				Preview->moveFloating();
+			}
+			Frames += Path.size();
+		}
+		qDebug() << DockAreaCount << "dock areas:" << Timer.nsecsElapsed() / 1000.0 / Frames
+			<< "us per drag frame";
+
+		// Cancel the drag without dropping the widget
+		DockManager->containerOverlay()->hideOverlay();
+		DockManager->dockAreaOverlay()->hideOverlay();
+		delete Preview;
+	}
+};
+
+//---------------------------------------------------------------------------
+#endif // Test_DockDragH
@@ -0,0 +1,13 @@
+QT += testlib widgets
+CONFIG += c++17
+TARGET = AdvancedDockingSystem_Test
+
+include($$PWD/../advanceddockingsystem-lib.pri)
+
+INCLUDEPATH += $$PWD/..
+
+SOURCES += \
+    $$PWD/main.cpp
+
+HEADERS += \
+    $$PWD/Test_DockDrag.h
@@ -0,0 +1,27 @@
+//============================================================================
+/// \file   main.cpp
+/// \date   18.10.2026
+/// \brief  Runs the advanced docking system tests and benchmarks
+//============================================================================
+
+//============================================================================
+//                                   INCLUDES
+//============================================================================
+#include <QApplication>
+#include <QtTest>
+
+#include "Test_DockDrag.h"
+
+int main(int argc, char *argv[])
+{
+	QApplication app(argc, argv);
+	app.setApplicationName("Advanced Docking System Tests");
+
+	int Status = 0;
+	Status |= QTest::qExec(new Test_DockDrag, argc, argv);
+
+	return Status;
+}
+
+//---------------------------------------------------------------------------
+// EOF main.cpp
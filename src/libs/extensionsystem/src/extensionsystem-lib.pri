@@ -3,12 +3,15 @@ DEFINES += EXTENSIONSYSTEM_LIBRARY
 SOURCES += \
     $$PWD/iplugin.cpp \
     $$PWD/pluginsmanager_p.cpp \
-    $$PWD/pluginmanager.cpp
+    $$PWD/pluginmanager.cpp \
+    $$PWD/startupprofiler.cpp
 
 HEADERS += \
     $$PWD/iplugin.h \
     $$PWD/iplugin_p.h \
     $$PWD/pluginsmanager_p.h \
     $$PWD/pluginmanager.h\
+    $$PWD/startupprofiler.h \
+    $$PWD/startupprofiler_p.h \
     $$PWD/extensionsystem_global.h
 
@@ -18,6 +18,16 @@ void IPlugin::initialize()
 
 }
 
+void IPlugin::extensionsInitialized()
+{
+
+}
+
+bool IPlugin::delayedInitialize()
+{
+    return false;
+}
+
 
 /*************************************************************************************
  *
@@ -22,7 +22,15 @@ class EXTENSIONSYSTEMSHARED_EXPORT IPlugin : public QObject
 public:
     IPlugin();
     ~IPlugin() override;
+
+    //插件生命周期：依赖的插件总是先完成 initialize
+    //元数据声明 "concurrentInitialize": true 的插件会在线程池中调用 initialize，
+    //此时不能创建界面或依赖事件循环的对象，这类工作放到 extensionsInitialized 中
     virtual void initialize();
+    //所有插件 initialize 之后在主线程调用，依赖方先于被依赖方
+    virtual void extensionsInitialized();
+    //界面显示后在主线程逐个调用，用于耗时的初始化；返回 true 表示做了耗时工作，下一个插件稍后再执行
+    virtual bool delayedInitialize();
 
 private:
     IPluginPrivate *d;
@@ -1,11 +1,14 @@
 #include "pluginmanager.h"
 #include "pluginsmanager_p.h"
 #include "iplugin.h"
+#include "startupprofiler.h"
 
 #include <QDir>
 #include <QCoreApplication>
 #include <QJsonArray>
 #include <QPluginLoader>
+#include <QElapsedTimer>
+#include <QDebug>
 
 PluginManager* PluginManager::m_instance = nullptr;
 
@@ -22,19 +25,38 @@ PluginManager::~PluginManager()
 
 void PluginManager::loadAllPlugins()
 {
+    StartupProfiler::Scope scope("plugin", "loadAllPlugins");
     QDir pluginsdir = QDir(qApp->applicationDirPath());
     pluginsdir.cd("plugins");
 
-    QFileInfoList pluginsInfo = pluginsdir.entryInfoList(QDir::Files | QDir::NoDotAndDotDot);
+    QFileInfoList pluginsInfo;
+    QStringList pluginPaths;
+    for(const QFileInfo &fileinfo : pluginsdir.entryInfoList(QDir::Files | QDir::NoDotAndDotDot))
+    {
+        //判断是否为库（后缀有效性）
+        if(!QLibrary::isLibrary(fileinfo.absoluteFilePath()))
+            continue;
+        pluginsInfo.append(fileinfo);
+        pluginPaths.append(fileinfo.absoluteFilePath());
+    }
+
     //初始化插件中的元数据
-    for(QFileInfo fileinfo : pluginsInfo){
+    managerPrivate->scanAll(pluginsInfo);
 
-        scanMetaData(fileinfo.absoluteFilePath());
+    //声明了激活条件的插件只登记，等首次使用时再加载；被立即加载的插件依赖到的除外
+    QStringList eagerPaths;
+    for(const QString &filepath : pluginPaths)
+    {
+        if(!managerPrivate->m_lazyPlugins.contains(filepath))
+            eagerPaths.append(filepath);
     }
 
-    //加载插件
-    for(QFileInfo fileinfo : pluginsInfo)
-        loadPlugin(fileinfo.absoluteFilePath());
+    //依赖关系只解析一次，按依赖顺序加载插件
+    QElapsedTimer timer;
+    timer.start();
+    managerPrivate->loadPlugins(managerPrivate->resolveLoadOrder(eagerPaths));
+    qDebug() << "Plugins loaded:" << managerPrivate->m_loaders.size() << "of" << pluginPaths.size()
+             << "in" << timer.elapsed() << "ms";
 }
 
 void PluginManager::scanMetaData(const QString &filepath)
@@ -43,19 +65,8 @@ void PluginManager::scanMetaData(const QString &filepath)
     if(!QLibrary::isLibrary(filepath))
         return ;
 
-
     //获取元数据
-    QPluginLoader *loader = new QPluginLoader(filepath);
-
-    QJsonObject json = loader->metaData().value("MetaData").toObject();
-
-    QVariant var = json.value("name").toVariant();
-    managerPrivate->m_names.insert(filepath, json.value("name").toVariant());
-    managerPrivate->m_versions.insert(filepath, json.value("version").toVariant());
-    managerPrivate->m_dependencies.insert(filepath, json.value("dependencies").toArray().toVariantList());
-
-    delete loader;
-    loader = nullptr;
+    managerPrivate->addMetaData(PluginsManagerPrivate::readMetaData(QFileInfo(filepath)));
 }
 
 void PluginManager::loadPlugin(const QString &filepath)
@@ -68,24 +79,10 @@ void PluginManager::loadPlugin(const QString &filepath)
         return;
 
     //加载插件
-    QPluginLoader *loader = new QPluginLoader(filepath);
-    if(loader->load())
-    {
-        IPlugin *plugin = qobject_cast<IPlugin *>(loader->instance());
-        if(plugin)
-        {
-            managerPrivate->m_loaders.insert(filepath, loader);
-            plugin->initialize();
-            //plugin->connect_information(this, SLOT(onPluginInformation(QString&)), true);
-
-        }
-        else
-        {
-            delete loader;
-            loader = nullptr;
-        }
-    }else{
-    }
+    if(managerPrivate->m_loaders.contains(filepath))
+        return;
+    if(managerPrivate->loadPlugins(QStringList() << filepath))
+        emit pluginActivated(managerPrivate->m_names.value(filepath).toString());
 }
 
 void PluginManager::unloadAllPlugins()
@@ -126,5 +123,54 @@ QVariant PluginManager::getPluginName(QPluginLoader *loader)
 
 QPluginLoader *PluginManager::getPlugin(const QString &name)
 {
-    return managerPrivate->m_loaders.value(managerPrivate->m_names.key(name));
+    //延迟激活的插件在首次获取时加载
+    activatePlugin(name);
+    return managerPrivate->m_loaders.value(managerPrivate->m_paths.value(name));
+}
+
+bool PluginManager::isLazyPlugin(const QString &name)
+{
+    return managerPrivate->m_lazyPlugins.contains(managerPrivate->m_paths.value(name));
+}
+
+bool PluginManager::isPluginActive(const QString &name)
+{
+    return managerPrivate->m_loaders.contains(managerPrivate->m_paths.value(name));
+}
+
+bool PluginManager::activatePlugin(const QString &name)
+{
+    QString filepath = managerPrivate->m_paths.value(name);
+    if(filepath.isEmpty())
+        return false;
+    if(managerPrivate->m_loaders.contains(filepath))
+        return true;
+
+    int loadedCount = managerPrivate->m_loadOrder.size();
+    bool activated = managerPrivate->activate(filepath);
+    //连同依赖一起加载的插件都通知出去
+    for(int i = loadedCount; i < managerPrivate->m_loadOrder.size(); ++i)
+        emit pluginActivated(managerPrivate->m_names.value(managerPrivate->m_loadOrder.at(i)).toString());
+    return activated;
+}
+
+QPluginLoader *PluginManager::activate(ActivationTrigger trigger, const QString &value)
+{
+    QString filepath = managerPrivate->m_triggers.value(trigger).value(PluginsManagerPrivate::triggerKey(trigger, value));
+    if(filepath.isEmpty())
+        return nullptr;
+
+    if(!activatePlugin(managerPrivate->m_names.value(filepath).toString()))
+        return nullptr;
+    return managerPrivate->m_loaders.value(filepath);
+}
+
+QStringList PluginManager::triggers(ActivationTrigger trigger)
+{
+    return managerPrivate->m_triggers.value(trigger).keys();
+}
+
+QStringList PluginManager::loadOrder() const
+{
+    return managerPrivate->m_loadOrder;
 }
@@ -12,6 +12,14 @@ class EXTENSIONSYSTEMSHARED_EXPORT PluginManager:public QObject
 {
     Q_OBJECT
 public:
+    //插件激活条件，对应插件元数据 activation 对象中的 commands、fileTypes、dockWidgets
+    enum ActivationTrigger
+    {
+        CommandTrigger,
+        FileTypeTrigger,
+        DockWidgetTrigger
+    };
+
     PluginManager();
     ~PluginManager();
 
@@ -48,6 +56,28 @@ public:
     //根据名称获得插件
     QPluginLoader* getPlugin(const QString &name);
 
+    //获取插件实际加载的顺序（插件路径，被依赖的在前）
+    QStringList loadOrder() const;
+
+    //插件是否声明了激活条件（首次使用时才加载）
+    bool isLazyPlugin(const QString &name);
+
+    //插件是否已加载并初始化
+    bool isPluginActive(const QString &name);
+
+    //加载并初始化插件及其依赖，已加载时直接返回 true
+    bool activatePlugin(const QString &name);
+
+    //按激活条件查找并激活插件，如 activate(FileTypeTrigger, "txt")；没有插件声明该条件时返回 nullptr
+    QPluginLoader *activate(ActivationTrigger trigger, const QString &value);
+
+    //已登记的某类激活条件
+    QStringList triggers(ActivationTrigger trigger);
+
+signals:
+    //插件被加载并初始化
+    void pluginActivated(const QString &name);
+
 private:
     static PluginManager *m_instance;
     PluginsManagerPrivate *managerPrivate;
@@ -1,35 +1,64 @@
 #include "pluginsmanager_p.h"
+#include "pluginmanager.h"
 #include "iplugin.h"
+#include "startupprofiler.h"
 
 #include <QVariantMap>
 #include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QStandardPaths>
+#include <QtConcurrent>
+#include <QTimer>
+#include <QCoreApplication>
 #include <QtWidgets/QMessageBox>
 
+namespace {
+const int MetaDataCacheVersion = 1;
+//两个插件的延迟初始化之间的间隔，让出事件循环给界面绘制
+const int DelayedInitializeInterval = 20;
+
+//元数据 activation 对象中各触发类型对应的字段，顺序与 PluginManager::ActivationTrigger 一致
+const char *const TriggerKeys[] = { "commands", "fileTypes", "dockWidgets" };
+}
 
 bool PluginsManagerPrivate::check(const QString &filepath)
 {
+    //检测结果缓存起来，被多个插件依赖的插件只检测一次
+    auto checked = m_checked.constFind(filepath);
+    if(checked != m_checked.constEnd())
+        return checked.value();
+
+    //先记为不通过，依赖成环时再次进入直接返回
+    m_checked.insert(filepath, false);
+
     for(QVariant item : m_dependencies.value(filepath))
     {
         QVariantMap map = item.toMap();
         //依赖的插件名称、版本、路径
         QVariant name = map.value("name");
         QVariant version = map.value("version");
-        QString path = m_names.key(name);
 
         /********** 检测插件是否依赖于其他插件 **********/
         // 先检测插件名称
-        if(!m_names.values().contains(name))
+        auto pathIt = m_paths.constFind(name.toString());
+        if(pathIt == m_paths.constEnd())
         {
-            QString strcons = "Missing dependency: "+ name.toString()+" for plugin "+path;
+            QString strcons = "Missing dependency: "+ name.toString()+" for plugin "+filepath;
             qDebug()<<Q_FUNC_INFO<<strcons;
             //QMessageBox::warning(nullptr, ("Plugins Loader Error"), strcons, QMessageBox::Ok);
             return false;
         }
+        QString path = pathIt.value();
         //再检测插件版本
         if(m_versions.value(path) != version)
         {
-            QString strcons = "Version mismatch: " + name.toString() +" version "+m_versions.value(m_names.key(name)).toString()+
-                    " but " + version.toString() + " required for plugin "+path;
+            QString strcons = "Version mismatch: " + name.toString() +" version "+m_versions.value(path).toString()+
+                    " but " + version.toString() + " required for plugin "+filepath;
             qDebug()<<Q_FUNC_INFO<<strcons;
             //QMessageBox::warning(nullptr, "Plugins Loader Error", strcons, QMessageBox::Ok);
             return false;
@@ -37,12 +66,427 @@ bool PluginsManagerPrivate::check(const QString &filepath)
         //最后检测被依赖的插件是否还依赖其他的插件
         if(!check(path))
         {
-            QString strcons = "Corrupted dependency: "+name.toString()+" for plugin "+path;
+            QString strcons = "Corrupted dependency: "+name.toString()+" for plugin "+filepath;
             qDebug()<<Q_FUNC_INFO<<strcons;
             //QMessageBox::warning(nullptr, "Plugins Loader Error", strcons, QMessageBox::Ok);
             return false;
         }
     }
 
+    m_checked.insert(filepath, true);
+    return true;
+}
+
+PluginMetaData PluginsManagerPrivate::readMetaData(const QFileInfo &fileInfo)
+{
+    PluginMetaData data;
+    data.filePath = fileInfo.absoluteFilePath();
+    data.size = fileInfo.size();
+    data.lastModified = fileInfo.lastModified().toMSecsSinceEpoch();
+
+    //QPluginLoader 只解析文件中的元数据段，不会加载库
+    QPluginLoader loader(data.filePath);
+    data.metaData = loader.metaData().value("MetaData").toObject();
+    return data;
+}
+
+void PluginsManagerPrivate::scanAll(const QFileInfoList &files)
+{
+    StartupProfiler::Scope scope("plugin", "scan metadata");
+    loadMetaDataCache();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QList<QFileInfo> misses;
+    QSet<QString> scanned;
+    for(const QFileInfo &fileInfo : files)
+    {
+        QString filepath = fileInfo.absoluteFilePath();
+        scanned.insert(filepath);
+
+        auto cached = m_metaDataCache.constFind(filepath);
+        if(cached != m_metaDataCache.constEnd()
+                && cached.value().size == fileInfo.size()
+                && cached.value().lastModified == fileInfo.lastModified().toMSecsSinceEpoch())
+        {
+            addMetaData(cached.value());
+        }
+        else
+        {
+            misses.append(fileInfo);
+        }
+    }
+
+    //未命中缓存的文件并行读取元数据
+    QList<PluginMetaData> results = QtConcurrent::blockingMapped<QList<PluginMetaData> >(misses, &PluginsManagerPrivate::readMetaData);
+    for(const PluginMetaData &data : results)
+    {
+        addMetaData(data);
+        m_metaDataCache.insert(data.filePath, data);
+        m_cacheDirty = true;
+    }
+
+    //已删除的插件从缓存中移除
+    for(auto it = m_metaDataCache.begin(); it != m_metaDataCache.end();)
+    {
+        if(scanned.contains(it.key()))
+        {
+            ++it;
+        }
+        else
+        {
+            it = m_metaDataCache.erase(it);
+            m_cacheDirty = true;
+        }
+    }
+
+    saveMetaDataCache();
+
+    qDebug() << "Plugin metadata scanned:" << files.size() << "files,"
+             << (files.size() - misses.size()) << "from cache, in" << timer.elapsed() << "ms";
+}
+
+void PluginsManagerPrivate::addMetaData(const PluginMetaData &data)
+{
+    QVariant name = data.metaData.value("name").toVariant();
+    m_names.insert(data.filePath, name);
+    m_versions.insert(data.filePath, data.metaData.value("version").toVariant());
+    m_dependencies.insert(data.filePath, data.metaData.value("dependencies").toArray().toVariantList());
+    if(!name.toString().isEmpty())
+        m_paths.insert(name.toString(), data.filePath);
+
+    if(data.metaData.value("concurrentInitialize").toBool())
+        m_concurrentPlugins.insert(data.filePath);
+    else
+        m_concurrentPlugins.remove(data.filePath);
+
+    //重新扫描时先去掉该插件上次登记的触发条件，activation 改变或删除后旧条件不再激活它
+    m_lazyPlugins.remove(data.filePath);
+    for(auto triggers = m_triggers.begin(); triggers != m_triggers.end(); ++triggers)
+    {
+        for(auto it = triggers.value().begin(); it != triggers.value().end();)
+        {
+            if(it.value() == data.filePath)
+                it = triggers.value().erase(it);
+            else
+                ++it;
+        }
+    }
+
+    //声明了 activation 的插件只登记触发条件，首次使用时再加载
+    QJsonValue activation = data.metaData.value("activation");
+    if(activation.isObject())
+    {
+        m_lazyPlugins.insert(data.filePath);
+        QJsonObject triggers = activation.toObject();
+        for(int trigger = 0; trigger < int(sizeof(TriggerKeys) / sizeof(TriggerKeys[0])); ++trigger)
+        {
+            for(const QJsonValue &value : triggers.value(TriggerKeys[trigger]).toArray())
+                m_triggers[trigger].insert(triggerKey(trigger, value.toString()), data.filePath);
+        }
+    }
+
+    //元数据变化后依赖需要重新检测
+    m_checked.clear();
+}
+
+QStringList PluginsManagerPrivate::resolveLoadOrder(const QStringList &filepaths)
+{
+    //深度优先后序遍历，依赖的插件总排在前面；同一层级保持目录顺序
+    QStringList order;
+    QSet<QString> visited;
+    for(const QString &filepath : filepaths)
+    {
+        if(check(filepath))
+            visit(filepath, visited, order);
+    }
+    return order;
+}
+
+void PluginsManagerPrivate::visit(const QString &filepath, QSet<QString> &visited, QStringList &order)
+{
+    if(visited.contains(filepath))
+        return;
+    visited.insert(filepath);
+
+    //check 已保证依赖存在且无环
+    for(const QVariant &item : m_dependencies.value(filepath))
+    {
+        visit(m_paths.value(item.toMap().value("name").toString()), visited, order);
+    }
+    order.append(filepath);
+}
+
+IPlugin *PluginsManagerPrivate::plugin(const QString &filepath) const
+{
+    QPluginLoader *loader = m_loaders.value(filepath);
+    return loader ? qobject_cast<IPlugin *>(loader->instance()) : nullptr;
+}
+
+bool PluginsManagerPrivate::loadLibrary(const QString &filepath)
+{
+    if(m_loaders.contains(filepath))
+        return true;
+
+    StartupProfiler::Scope scope;
+    if (StartupProfiler::isEnabled())
+        scope.start("plugin", "load " + m_names.value(filepath).toString());
+    QElapsedTimer timer;
+    timer.start();
+
+    //加载插件
+    QPluginLoader *loader = new QPluginLoader(filepath);
+    if(!loader->load())
+    {
+        qDebug() << Q_FUNC_INFO << loader->errorString();
+        delete loader;
+        return false;
+    }
+
+    IPlugin *plugin = qobject_cast<IPlugin *>(loader->instance());
+    if(!plugin)
+    {
+        delete loader;
+        return false;
+    }
+
+    m_loaders.insert(filepath, loader);
+    m_loadOrder.append(filepath);
+    //plugin->connect_information(this, SLOT(onPluginInformation(QString&)), true);
+
+    qDebug() << "Plugin" << m_names.value(filepath).toString() << "loaded in" << timer.elapsed() << "ms";
     return true;
 }
+
+void PluginsManagerPrivate::initializePlugin(IPlugin *plugin, const QString &name)
+{
+    StartupProfiler::Scope scope;
+    if (StartupProfiler::isEnabled())
+        scope.start("plugin", "initialize " + name);
+    QElapsedTimer timer;
+    timer.start();
+    plugin->initialize();
+    qDebug() << "Plugin" << name << "initialized in" << timer.elapsed() << "ms";
+}
+
+void PluginsManagerPrivate::initializePlugins(const QStringList &filepaths)
+{
+    //按依赖深度分层：同一层的插件互不依赖，上一层全部初始化完才开始下一层
+    QHash<QString, int> levels;
+    QList<QStringList> layers;
+    for(const QString &filepath : filepaths)
+    {
+        int level = 0;
+        for(const QVariant &item : m_dependencies.value(filepath))
+        {
+            QString path = m_paths.value(item.toMap().value("name").toString());
+            if(levels.contains(path))
+                level = qMax(level, levels.value(path) + 1);
+        }
+        levels.insert(filepath, level);
+        if(layers.size() <= level)
+            layers.append(QStringList());
+        layers[level].append(filepath);
+    }
+
+    for(const QStringList &layer : layers)
+    {
+        //声明了 concurrentInitialize 的插件放到线程池，其余插件在主线程依次初始化
+        QList<QFuture<void> > futures;
+        for(const QString &filepath : layer)
+        {
+            if(m_concurrentPlugins.contains(filepath))
+            {
+                IPlugin *instance = plugin(filepath);
+                QString name = m_names.value(filepath).toString();
+                futures.append(QtConcurrent::run([instance, name]() {
+                    initializePlugin(instance, name);
+                }));
+            }
+        }
+        for(const QString &filepath : layer)
+        {
+            if(!m_concurrentPlugins.contains(filepath))
+                initializePlugin(plugin(filepath), m_names.value(filepath).toString());
+        }
+        for(QFuture<void> &future : futures)
+            future.waitForFinished();
+    }
+}
+
+bool PluginsManagerPrivate::loadPlugins(const QStringList &order)
+{
+    //先在主线程加载全部库，依赖加载失败的插件跳过，每个插件只报告一次
+    QStringList loaded;
+    QSet<QString> failed;
+    for(const QString &filepath : order)
+    {
+        if(m_loaders.contains(filepath))
+            continue;
+
+        QString failedDependency;
+        for(const QVariant &item : m_dependencies.value(filepath))
+        {
+            QString name = item.toMap().value("name").toString();
+            if(failed.contains(m_paths.value(name)))
+            {
+                failedDependency = name;
+                break;
+            }
+        }
+        if(!failedDependency.isEmpty())
+        {
+            qDebug() << Q_FUNC_INFO << "Dependency failed to load:" << failedDependency << "for plugin" << filepath;
+            failed.insert(filepath);
+            continue;
+        }
+
+        if(loadLibrary(filepath))
+            loaded.append(filepath);
+        else
+            failed.insert(filepath);
+    }
+
+    initializePlugins(loaded);
+
+    //依赖方先于被依赖方收到 extensionsInitialized，此时被依赖插件提供的扩展都已注册
+    for(int i = loaded.size() - 1; i >= 0; --i)
+    {
+        StartupProfiler::Scope scope;
+        if (StartupProfiler::isEnabled())
+            scope.start("plugin", "extensionsInitialized " + m_names.value(loaded.at(i)).toString());
+        plugin(loaded.at(i))->extensionsInitialized();
+    }
+
+    //耗时的工作放到事件循环启动、界面显示之后
+    m_delayedQueue.append(loaded);
+    scheduleDelayedInitialize(DelayedInitializeInterval);
+    return failed.isEmpty();
+}
+
+void PluginsManagerPrivate::scheduleDelayedInitialize(int msecs)
+{
+    if(m_delayedScheduled || m_delayedQueue.isEmpty())
+        return;
+    m_delayedScheduled = true;
+    QTimer::singleShot(msecs, qApp, [this]() {
+        m_delayedScheduled = false;
+        nextDelayedInitialize();
+    });
+}
+
+void PluginsManagerPrivate::nextDelayedInitialize()
+{
+    //每次事件循环只执行一个插件，插件返回 true 表示做了耗时工作，稍后再继续
+    while(!m_delayedQueue.isEmpty())
+    {
+        QString filepath = m_delayedQueue.takeFirst();
+        IPlugin *instance = plugin(filepath);
+        if(!instance)
+            continue;
+
+        StartupProfiler::Scope scope;
+        if (StartupProfiler::isEnabled())
+            scope.start("plugin", "delayedInitialize " + m_names.value(filepath).toString());
+        QElapsedTimer timer;
+        timer.start();
+        bool busy = instance->delayedInitialize();
+        qDebug() << "Plugin" << m_names.value(filepath).toString() << "delayed initialized in" << timer.elapsed() << "ms";
+
+        scheduleDelayedInitialize(busy ? DelayedInitializeInterval : 0);
+        return;
+    }
+}
+
+bool PluginsManagerPrivate::activate(const QString &filepath)
+{
+    if(m_loaders.contains(filepath))
+        return true;
+
+    QStringList order = resolveLoadOrder(QStringList() << filepath);
+    if(order.isEmpty())
+        return false;
+
+    loadPlugins(order);
+    return m_loaders.contains(filepath);
+}
+
+QString PluginsManagerPrivate::triggerKey(int trigger, const QString &value)
+{
+    if(trigger != PluginManager::FileTypeTrigger)
+        return value;
+
+    //文件类型可写成 "txt"、".txt" 或 "*.txt"
+    QString suffix = value.trimmed().toLower();
+    if(suffix.startsWith("*"))
+        suffix.remove(0, 1);
+    if(suffix.startsWith("."))
+        suffix.remove(0, 1);
+    return suffix;
+}
+
+QString PluginsManagerPrivate::metaDataCacheFile() const
+{
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if(dir.isEmpty())
+        dir = QDir::tempPath();
+    return dir + "/pluginmetadata.json";
+}
+
+void PluginsManagerPrivate::loadMetaDataCache()
+{
+    if(m_cacheLoaded)
+        return;
+    m_cacheLoaded = true;
+
+    QFile file(metaDataCacheFile());
+    if(!file.open(QIODevice::ReadOnly))
+        return;
+
+    QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    if(root.value("version").toInt() != MetaDataCacheVersion)
+        return;
+
+    for(const QJsonValue &value : root.value("plugins").toArray())
+    {
+        QJsonObject entry = value.toObject();
+        PluginMetaData data;
+        data.filePath = entry.value("path").toString();
+        data.size = static_cast<qint64>(entry.value("size").toDouble());
+        data.lastModified = static_cast<qint64>(entry.value("lastModified").toDouble());
+        data.metaData = entry.value("metaData").toObject();
+        m_metaDataCache.insert(data.filePath, data);
+    }
+}
+
+void PluginsManagerPrivate::saveMetaDataCache()
+{
+    if(!m_cacheDirty)
+        return;
+
+    QJsonArray plugins;
+    for(const PluginMetaData &data : m_metaDataCache)
+    {
+        QJsonObject entry;
+        entry.insert("path", data.filePath);
+        entry.insert("size", static_cast<double>(data.size));
+        entry.insert("lastModified", static_cast<double>(data.lastModified));
+        entry.insert("metaData", data.metaData);
+        plugins.append(entry);
+    }
+    QJsonObject root;
+    root.insert("version", MetaDataCacheVersion);
+    root.insert("plugins", plugins);
+
+    QString fileName = metaDataCacheFile();
+    QDir().mkpath(QFileInfo(fileName).absolutePath());
+    QFile file(fileName);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qDebug() << Q_FUNC_INFO << "cannot write plugin metadata cache" << fileName;
+        return;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    m_cacheDirty = false;
+}
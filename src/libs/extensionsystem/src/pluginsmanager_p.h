@@ -1,20 +1,79 @@
 #ifndef QTPLUGINSMANAGERPRIVATE_H
 #define QTPLUGINSMANAGERPRIVATE_H
 #include <QHash>
+#include <QSet>
 #include <QVariant>
+#include <QJsonObject>
+#include <QFileInfo>
 #include <QPluginLoader>
 
 class IPlugin;
 
+/**
+ * @brief 插件元数据，按文件路径、大小和修改时间缓存到磁盘
+ */
+struct PluginMetaData
+{
+    QString filePath;
+    qint64 size = 0;
+    qint64 lastModified = 0;    //修改时间（毫秒）
+    QJsonObject metaData;       //插件 JSON 中的 MetaData 部分
+};
+
 class PluginsManagerPrivate
 {
 public:
     //插件依赖检测
     bool check(const QString &filepath);
 
+    //读取单个插件的元数据，不加载库，可在工作线程中调用
+    static PluginMetaData readMetaData(const QFileInfo &fileInfo);
+    //并行扫描插件元数据，大小和修改时间未变的直接取缓存
+    void scanAll(const QFileInfoList &files);
+    //记录插件元数据
+    void addMetaData(const PluginMetaData &data);
+    //按依赖关系排出加载顺序，被依赖的插件在前，依赖不满足的插件不参与加载
+    QStringList resolveLoadOrder(const QStringList &filepaths);
+    //按顺序加载一组插件并走完生命周期：initialize -> extensionsInitialized，delayedInitialize 排队延后执行
+    bool loadPlugins(const QStringList &order);
+    //只加载库并创建插件实例，记录耗时
+    bool loadLibrary(const QString &filepath);
+    //按依赖层级初始化插件，同一层中可并发的插件放到线程池
+    void initializePlugins(const QStringList &filepaths);
+    static void initializePlugin(IPlugin *plugin, const QString &name);
+    IPlugin *plugin(const QString &filepath) const;
+    //激活插件：连同尚未加载的依赖一起按顺序加载
+    bool activate(const QString &filepath);
+    //触发条件统一格式：文件类型去掉前缀的 "*." 并转小写
+    static QString triggerKey(int trigger, const QString &value);
+
+    void loadMetaDataCache();
+    void saveMetaDataCache();
+    QString metaDataCacheFile() const;
+
     QHash<QString, QVariant> m_names; //插件路径--插件名称
     QHash<QString, QVariant> m_versions; //插件路径--插件版本
     QHash<QString, QVariantList>m_dependencies; //插件路径--插件额外依赖的其他插件
     QHash<QString, QPluginLoader *>m_loaders; //插件路径--QPluginLoader实例
+
+    QHash<QString, QString> m_paths; //插件名称--插件路径
+    QHash<QString, bool> m_checked; //插件路径--依赖检测结果
+    QStringList m_loadOrder; //插件实际加载的顺序
+
+    QSet<QString> m_concurrentPlugins; //元数据声明 concurrentInitialize、可在工作线程初始化的插件路径
+    QStringList m_delayedQueue; //等待 delayedInitialize 的插件路径
+    bool m_delayedScheduled = false;
+
+    QSet<QString> m_lazyPlugins; //声明了激活条件、延迟到首次使用时加载的插件路径
+    QHash<int, QHash<QString, QString> > m_triggers; //触发类型--(触发值--插件路径)
+
+    QHash<QString, PluginMetaData> m_metaDataCache; //插件路径--缓存的元数据
+    bool m_cacheLoaded = false;
+    bool m_cacheDirty = false;
+
+private:
+    void scheduleDelayedInitialize(int msecs);
+    void nextDelayedInitialize();
+    void visit(const QString &filepath, QSet<QString> &visited, QStringList &order);
 };
 #endif // QTPLUGINSMANAGERPRIVATE_H
@@ -0,0 +1,329 @@
+#include "startupprofiler.h"
+#include "startupprofiler_p.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QEvent>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QThread>
+#include <QTimer>
+#include <algorithm>
+
+#if defined(Q_OS_WIN)
+#include <qt_windows.h>
+#elif defined(Q_OS_UNIX)
+#include <time.h>
+#endif
+
+namespace {
+const char ProfileArgument[] = "--startup-profile";
+const char ProfileEnvironment[] = "QTPROJECT_STARTUP_PROFILE";
+const char DefaultTraceFile[] = "startup-trace.json";
+
+struct ProfilerData
+{
+    QMutex mutex;
+    QVector<StartupProfiler::Phase> phases;
+    QString traceFile;
+    bool finished = false;
+};
+
+ProfilerData *profilerData()
+{
+    static ProfilerData *data = new ProfilerData;
+    return data;
+}
+
+//首个绘制事件分发完后记录“首次绘制”并写出结果
+class FirstPaintFilter : public QObject
+{
+public:
+    explicit FirstPaintFilter(QObject *parent)
+        : QObject(parent), m_scope(QStringLiteral("app"), QStringLiteral("first paint"))
+    {
+    }
+
+    bool eventFilter(QObject *watched, QEvent *event) override
+    {
+        bool painted = event->type() == QEvent::Paint
+                || (event->type() == QEvent::UpdateRequest && watched->isWindowType());
+        if (painted && !m_painted)
+        {
+            m_painted = true;
+            //同一轮绘制中的其他窗口部件画完后再结束
+            QTimer::singleShot(0, this, [this]() {
+                m_scope.finish();
+                StartupProfiler::finish();
+                deleteLater();
+            });
+        }
+        return false;
+    }
+
+private:
+    StartupProfiler::Scope m_scope;
+    bool m_painted = false;
+};
+}
+
+QAtomicInt StartupProfiler::m_enabled(0);
+
+bool StartupProfiler::enableFromArguments(int argc, char *argv[])
+{
+    QString traceFile = QString::fromLocal8Bit(qgetenv(ProfileEnvironment));
+    bool enabled = !traceFile.isEmpty();
+
+    const int argumentLength = int(sizeof(ProfileArgument)) - 1;
+    for (int i = 1; i < argc; ++i)
+    {
+        QByteArray argument(argv[i]);
+        if (!argument.startsWith(ProfileArgument))
+            continue;
+        if (argument.size() == argumentLength)
+        {
+            enabled = true;
+        }
+        else if (argument.at(argumentLength) == '=')
+        {
+            enabled = true;
+            traceFile = QString::fromLocal8Bit(argument.mid(argumentLength + 1));
+        }
+    }
+
+    //环境变量设为 1 时只开启，不指定文件
+    if (traceFile == QLatin1String("1"))
+        traceFile.clear();
+
+    if (enabled)
+        setEnabled(true, traceFile);
+    return enabled;
+}
+
+void StartupProfiler::setEnabled(bool enabled, const QString &traceFile)
+{
+    ProfilerData *data = profilerData();
+    {
+        QMutexLocker locker(&data->mutex);
+        data->traceFile = traceFile.isEmpty() ? QString::fromLatin1(DefaultTraceFile) : traceFile;
+    }
+    //从开启时刻起计时
+    now();
+    m_enabled.storeRelease(enabled ? 1 : 0);
+}
+
+bool StartupProfiler::isEnabled()
+{
+    return m_enabled.loadAcquire() != 0;
+}
+
+qint64 StartupProfiler::now()
+{
+    static QElapsedTimer *timer = []() {
+        QElapsedTimer *timer = new QElapsedTimer;
+        timer->start();
+        return timer;
+    }();
+    return timer->nsecsElapsed();
+}
+
+qint64 StartupProfiler::threadCpuTime()
+{
+#if defined(Q_OS_WIN)
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if (!GetThreadTimes(GetCurrentThread(), &creationTime, &exitTime, &kernelTime, &userTime))
+        return 0;
+    ULARGE_INTEGER kernel, user;
+    kernel.LowPart = kernelTime.dwLowDateTime;
+    kernel.HighPart = kernelTime.dwHighDateTime;
+    user.LowPart = userTime.dwLowDateTime;
+    user.HighPart = userTime.dwHighDateTime;
+    //单位是 100 纳秒
+    return qint64(kernel.QuadPart + user.QuadPart) * 100;
+#elif defined(Q_OS_UNIX)
+    timespec time;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0)
+        return 0;
+    return qint64(time.tv_sec) * 1000000000 + time.tv_nsec;
+#else
+    return 0;
+#endif
+}
+
+void StartupProfiler::record(const QString &category, const QString &name, qint64 startNs, qint64 wallNs, qint64 cpuNs)
+{
+    if (!isEnabled())
+        return;
+
+    Phase phase;
+    phase.name = name;
+    phase.category = category;
+    phase.startNs = startNs;
+    phase.wallNs = wallNs;
+    phase.cpuNs = cpuNs;
+    phase.threadId = reinterpret_cast<quintptr>(QThread::currentThreadId());
+
+    ProfilerData *data = profilerData();
+    QMutexLocker locker(&data->mutex);
+    data->phases.append(phase);
+}
+
+QVector<StartupProfiler::Phase> StartupProfiler::phases()
+{
+    ProfilerData *data = profilerData();
+    QMutexLocker locker(&data->mutex);
+    return data->phases;
+}
+
+void StartupProfiler::traceSignals(QObject *sender, const char *beginSignal, const char *endSignal,
+                                   const QString &category, const QString &name)
+{
+    if (!isEnabled() || sender == nullptr)
+        return;
+
+    //按字符串连接信号，提供信号的库无需链接本库
+    SignalPhaseTracer *tracer = new SignalPhaseTracer(category, name, sender);
+    QObject::connect(sender, beginSignal, tracer, SLOT(begin()));
+    QObject::connect(sender, endSignal, tracer, SLOT(end()));
+}
+
+void StartupProfiler::traceFirstPaint()
+{
+    if (!isEnabled() || QCoreApplication::instance() == nullptr)
+        return;
+
+    QCoreApplication *app = QCoreApplication::instance();
+    app->installEventFilter(new FirstPaintFilter(app));
+    //没有窗口时在退出前写出
+    QObject::connect(app, &QCoreApplication::aboutToQuit, &StartupProfiler::finish);
+}
+
+QByteArray StartupProfiler::toChromeTrace()
+{
+    const QVector<Phase> allPhases = phases();
+    qint64 pid = QCoreApplication::applicationPid();
+
+    QJsonArray events;
+    QHash<quintptr, int> threadIds;//线程按出现顺序编号
+    for (const Phase &phase : allPhases)
+    {
+        if (!threadIds.contains(phase.threadId))
+            threadIds.insert(phase.threadId, threadIds.size() + 1);
+
+        QJsonObject args;
+        args.insert(QStringLiteral("cpuMs"), phase.cpuNs / 1e6);
+
+        QJsonObject event;
+        event.insert(QStringLiteral("name"), phase.name);
+        event.insert(QStringLiteral("cat"), phase.category);
+        event.insert(QStringLiteral("ph"), QStringLiteral("X"));
+        event.insert(QStringLiteral("ts"), phase.startNs / 1000.0);
+        event.insert(QStringLiteral("dur"), phase.wallNs / 1000.0);
+        event.insert(QStringLiteral("pid"), pid);
+        event.insert(QStringLiteral("tid"), threadIds.value(phase.threadId));
+        event.insert(QStringLiteral("args"), args);
+        events.append(event);
+    }
+
+    QJsonObject root;
+    root.insert(QStringLiteral("traceEvents"), events);
+    root.insert(QStringLiteral("displayTimeUnit"), QStringLiteral("ms"));
+    return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
+
+QString StartupProfiler::summary()
+{
+    struct Total
+    {
+        QString category;
+        QString name;
+        int count = 0;
+        qint64 wallNs = 0;
+        qint64 cpuNs = 0;
+    };
+
+    //同名阶段合并，如多次构造的同一单例
+    QHash<QString, Total> totals;
+    qint64 endNs = 0;
+    for (const Phase &phase : phases())
+    {
+        Total &total = totals[phase.category + QLatin1Char('/') + phase.name];
+        total.category = phase.category;
+        total.name = phase.name;
+        total.count++;
+        total.wallNs += phase.wallNs;
+        total.cpuNs += phase.cpuNs;
+        endNs = qMax(endNs, phase.startNs + phase.wallNs);
+    }
+
+    QVector<Total> rows;
+    rows.reserve(totals.size());
+    for (const Total &total : totals)
+        rows.append(total);
+    std::sort(rows.begin(), rows.end(), [](const Total &left, const Total &right) {
+        return left.wallNs > right.wallNs;
+    });
+
+    QString report;
+    report += QStringLiteral("startup: %1 ms\n").arg(endNs / 1e6, 0, 'f', 2);
+    report += QStringLiteral("%1 %2 %3 %4 %5\n")
+                  .arg(QStringLiteral("category"), -10)
+                  .arg(QStringLiteral("phase"), -48)
+                  .arg(QStringLiteral("count"), 6)
+                  .arg(QStringLiteral("wall ms"), 12)
+                  .arg(QStringLiteral("cpu ms"), 12);
+    for (const Total &row : rows)
+    {
+        report += QStringLiteral("%1 %2 %3 %4 %5\n")
+                      .arg(row.category, -10)
+                      .arg(row.name, -48)
+                      .arg(row.count, 6)
+                      .arg(row.wallNs / 1e6, 12, 'f', 2)
+                      .arg(row.cpuNs / 1e6, 12, 'f', 2);
+    }
+    return report;
+}
+
+SignalPhaseTracer::SignalPhaseTracer(const QString &category, const QString &name, QObject *parent)
+    : QObject(parent), m_category(category), m_name(name)
+{
+}
+
+void SignalPhaseTracer::begin()
+{
+    m_scope.reset(new StartupProfiler::Scope(m_category, m_name));
+}
+
+void SignalPhaseTracer::end()
+{
+    m_scope.reset();
+}
+
+void StartupProfiler::finish()
+{
+    if (!isEnabled())
+        return;
+
+    ProfilerData *data = profilerData();
+    QString traceFile;
+    {
+        QMutexLocker locker(&data->mutex);
+        if (data->finished)
+            return;
+        data->finished = true;
+        traceFile = data->traceFile;
+    }
+
+    QFile file(traceFile);
+    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        file.write(toChromeTrace());
+    else
+        qDebug() << Q_FUNC_INFO << "cannot write startup trace" << traceFile;
+
+    qDebug().noquote() << summary();
+}
@@ -0,0 +1,117 @@
+#ifndef STARTUPPROFILER_H
+#define STARTUPPROFILER_H
+
+#include "extensionsystem_global.h"
+
+#include <QAtomicInt>
+#include <QString>
+#include <QVector>
+
+class QObject;
+
+/**
+ * @brief 启动耗时记录，默认关闭。
+ *        开启后记录各启动阶段的墙钟时间和所在线程的 CPU 时间，
+ *        首次绘制完成（或程序退出）时写出 Chrome trace JSON，并输出按耗时排序的汇总表
+ */
+class EXTENSIONSYSTEMSHARED_EXPORT StartupProfiler
+{
+public:
+    //一个阶段
+    struct Phase
+    {
+        QString name;
+        QString category;
+        qint64 startNs = 0;     //开始时间，相对于记录开始
+        qint64 wallNs = 0;      //墙钟耗时
+        qint64 cpuNs = 0;       //所在线程的 CPU 耗时
+        quintptr threadId = 0;
+    };
+
+    //命令行参数 --startup-profile[=文件] 或环境变量 QTPROJECT_STARTUP_PROFILE=文件 开启记录，
+    //需在构造 QApplication 之前调用；未指定文件时写到当前目录的 startup-trace.json
+    static bool enableFromArguments(int argc, char *argv[]);
+    static void setEnabled(bool enabled, const QString &traceFile = QString());
+    static bool isEnabled();
+
+    //单调时钟，纳秒
+    static qint64 now();
+    //当前线程的 CPU 时间，纳秒
+    static qint64 threadCpuTime();
+
+    static void record(const QString &category, const QString &name, qint64 startNs, qint64 wallNs, qint64 cpuNs);
+    static QVector<Phase> phases();
+
+    //sender 发出 beginSignal 到 endSignal 之间记为一个阶段，如停靠布局恢复：
+    //traceSignals(dockManager, SIGNAL(restoringState()), SIGNAL(stateRestored()), "ads", "restore dock layout")
+    static void traceSignals(QObject *sender, const char *beginSignal, const char *endSignal,
+                             const QString &category, const QString &name);
+
+    //在进入事件循环前调用：记录到首次绘制完成为止，然后写出结果
+    static void traceFirstPaint();
+
+    //Chrome trace 事件格式的 JSON
+    static QByteArray toChromeTrace();
+    //按阶段名汇总、墙钟耗时降序的表格
+    static QString summary();
+    //写出 trace 文件并输出汇总表，只执行一次
+    static void finish();
+
+    //作用域内的阶段，构造或 start() 时开始，析构或 finish() 时记录。
+    //名称需要拼接时先用默认构造，在 isEnabled() 为真时再 start()，关闭记录时不构造字符串：
+    //    StartupProfiler::Scope scope;
+    //    if (StartupProfiler::isEnabled())
+    //        scope.start("plugin", "load " + name);
+    class Scope
+    {
+    public:
+        Scope()
+            : m_startNs(-1)
+        {
+        }
+
+        Scope(const QString &category, const QString &name)
+            : m_startNs(-1)
+        {
+            start(category, name);
+        }
+
+        void start(const QString &category, const QString &name)
+        {
+            if (!StartupProfiler::isEnabled())
+                return;
+            finish();
+            m_category = category;
+            m_name = name;
+            m_cpuStartNs = StartupProfiler::threadCpuTime();
+            m_startNs = StartupProfiler::now();
+        }
+
+        ~Scope()
+        {
+            finish();
+        }
+
+        void finish()
+        {
+            if (m_startNs < 0)
+                return;
+            StartupProfiler::record(m_category, m_name, m_startNs, StartupProfiler::now() - m_startNs,
+                                    StartupProfiler::threadCpuTime() - m_cpuStartNs);
+            m_startNs = -1;
+        }
+
+    private:
+        QString m_category;
+        QString m_name;
+        qint64 m_startNs;
+        qint64 m_cpuStartNs = 0;
+
+        Q_DISABLE_COPY(Scope)
+    };
+
+private:
+    static QAtomicInt m_enabled;
+};
+
+#endif // STARTUPPROFILER_H
@@ -0,0 +1,25 @@
+#ifndef STARTUPPROFILER_P_H
+#define STARTUPPROFILER_P_H
+
+#include <QObject>
+#include <QScopedPointer>
+#include "startupprofiler.h"
+
+//把一对开始、结束信号之间记为一个启动阶段
+class SignalPhaseTracer : public QObject
+{
+    Q_OBJECT
+public:
+    SignalPhaseTracer(const QString &category, const QString &name, QObject *parent);
+
+public slots:
+    void begin();
+    void end();
+
+private:
+    QString m_category;
+    QString m_name;
+    QScopedPointer<StartupProfiler::Scope> m_scope;
+};
+
+#endif // STARTUPPROFILER_P_H
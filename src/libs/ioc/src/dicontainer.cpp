@@ -62,11 +62,18 @@ typedef QSharedPointer<CtorArg> CtorArgPtr;
 
 using namespace Ioc;
 
+static DIContainer::ConstructionHook &constructionHook()
+{
+    static DIContainer::ConstructionHook hook;
+    return hook;
+}
+
 class DIContainer::P : public QObject
 {
 public:
-    explicit P(QObject *parent = 0) :
-        QObject(parent)
+    explicit P(DIContainer *q, QObject *parent = 0) :
+        QObject(parent),
+        _q(q)
     {
     }
 
@@ -107,6 +114,14 @@ public:
         }
     }
 
+    void RegisterFactory(const QString &typeName, const QMetaObject &metaObject, std::function<QObject*(DIContainer&)> factory, bool isSingletonInstance)
+    {
+        if(ContainsMetaObject(typeName))//不允许多次注入
+            return;
+        RegisterMetaObject(typeName, metaObject, isSingletonInstance);
+        _factories.insert(typeName, factory);
+    }
+
     bool ContainsMetaObject(const QString &typeName)
     {
         return _metaObjects.contains(typeName);
@@ -169,21 +184,37 @@ public:
             return _singleInstances.value(typeName);
         }
 
+        //工厂注册的类型直接调用工厂，不经过元对象构造
+        auto factory = _factories.constFind(typeName);
+        if (factory != _factories.constEnd())
+        {
+            QObject *instance = NULL;
+            Construct(typeName, [&]() { instance = factory.value()(*_q); });
+            if (!instance)
+            {
+                qDebug() << "DIContainer: factory could not create an instance of class " << typeName;
+                return NULL;
+            }
+            return AddInstance(typeName, instance);
+        }
+
         QMetaObject metaObject = GetMeataObject(typeName);
         QMetaMethod constructorType = metaObject.constructor(0);
+        const QList<QByteArray> parameterTypes = constructorType.parameterTypes();
+        const QList<QByteArray> parameterNames = constructorType.parameterNames();
         QList<CtorArgPtr> ctorArguments;
 
         for (quint8 index = 0; index < 10; index++)
         {
-            if (index >= constructorType.parameterTypes().count())
+            if (index >= parameterTypes.count())
             {
                 CtorArgPtr ctorArg(new CtorArg("", 0));
                 ctorArguments << ctorArg;
                 continue;
             }
 
-            QString argType = constructorType.parameterTypes().at(index);
-            QString argName = constructorType.parameterNames().at(index);
+            QString argType = parameterTypes.at(index);
+            QString argName = parameterNames.at(index);
 
             if (argType == "QObject*" && argName == "parent")
             {
@@ -219,8 +250,11 @@ public:
 
         }
 
-        QObject  *instance = metaObject.newInstance(ctorArguments[0]->toQArg(), ctorArguments[1]->toQArg(), ctorArguments[2]->toQArg(), ctorArguments[3]->toQArg(), ctorArguments[4]->toQArg(),
-                                                   ctorArguments[5]->toQArg(),ctorArguments[6]->toQArg(),ctorArguments[7]->toQArg(),ctorArguments[8]->toQArg(),ctorArguments[9]->toQArg());
+        QObject  *instance = NULL;
+        Construct(typeName, [&]() {
+            instance = metaObject.newInstance(ctorArguments[0]->toQArg(), ctorArguments[1]->toQArg(), ctorArguments[2]->toQArg(), ctorArguments[3]->toQArg(), ctorArguments[4]->toQArg(),
+                                              ctorArguments[5]->toQArg(),ctorArguments[6]->toQArg(),ctorArguments[7]->toQArg(),ctorArguments[8]->toQArg(),ctorArguments[9]->toQArg());
+        });
 
         if (!instance)
         {
@@ -228,6 +262,26 @@ public:
             return NULL;
         }
 
+        return AddInstance(typeName, instance);
+    }
+
+    //执行构造，设置了构造钩子时交给钩子执行
+    void Construct(const QString &typeName, const std::function<void()> &construct)
+    {
+        const DIContainer::ConstructionHook &hook = constructionHook();
+        if (hook)
+        {
+            hook(typeName, _singleTypeMap.contains(typeName), construct);
+        }
+        else
+        {
+            construct();
+        }
+    }
+
+    //记录新生成的对象（单例或瞬态），并完成注入
+    QObject* AddInstance(const QString &typeName, QObject *instance)
+    {
         _instancesType.insert(instance, typeName);
         if (_singleTypeMap.contains(typeName))//单例
         {
@@ -289,7 +343,9 @@ private:
         value->deleteLater();
     }
 
+    DIContainer *_q;
     QHash<QString, QMetaObject> _metaObjects;
+    QHash<QString, std::function<QObject*(DIContainer&)>> _factories;
     QHash<QString, QHash<QString, QVariant> > _objects;
 
     QHash<QString, QObject*> _singleInstances;
@@ -300,7 +356,7 @@ private:
 
 DIContainer::DIContainer(QObject *parent) :
     QObject(parent),
-    _d(QSharedPointer<P>(new P))
+    _d(QSharedPointer<P>(new P(this)))
 {
     _d->AfterNewInstance = [this](QObject* instance) {
         if (auto diObj = dynamic_cast<IDIObjBase*>(instance)){
@@ -333,6 +389,11 @@ void DIContainer::ValueBind(const QString &key, const QVariant &value)
     _d->RegisterValue(value.typeName(), key, value);
 }
 
+void DIContainer::FactoryBind(const QMetaObject &typeMeta, std::function<QObject *(DIContainer &)> factory, bool isSingletonInstance)
+{
+    _d->RegisterFactory(typeMeta.className(), typeMeta, factory, isSingletonInstance);
+}
+
 void DIContainer::Collect0(QObject *value)
 {
     _d->Collect(value);
@@ -350,6 +411,11 @@ void DIContainer::Collects0(size_t size, ...)
     va_end(myArgs);
 }
 
+void DIContainer::SetConstructionHook(ConstructionHook hook)
+{
+    constructionHook() = hook;
+}
+
 QObject *DIContainer::Find0(QMetaObject metaObject)
 {
     return _d->Find(QString::fromLatin1(metaObject.className()));
@@ -22,6 +22,7 @@
 #include <QSharedPointer>
 #include <QVariant>
 #include <typeinfo>
+#include <functional>
 #include <QDebug>
 #include "idiobjbase.h"
 
@@ -72,6 +73,41 @@ public:
         ClassBind(static_cast<Type*>(0)->staticMetaObject, false);
     }
 
+    //通过工厂函数注册类型，解析时直接调用工厂，不经过元对象构造（默认单例）
+    template <typename Type>
+    void BindFactory(std::function<Type*(DIContainer&)> factory, bool isSingletonInstance = true)
+    {
+        QObject* objectFromType = static_cast<Type*>(0); Q_UNUSED(objectFromType);
+        FactoryBind(static_cast<Type*>(0)->staticMetaObject,
+                    [factory](DIContainer &ioc) -> QObject* { return factory(ioc); },
+                    isSingletonInstance);
+    }
+
+    //通过工厂函数注册接口和实现的关系（默认单例）
+    template <typename ResolvableType, typename Type>
+    void BindFactory(std::function<Type*(DIContainer&)> factory, bool isSingletonInstance = true)
+    {
+        QObject* objectFromResolvableType = static_cast<ResolvableType*>(0); Q_UNUSED(objectFromResolvableType);
+        ResolvableType* resolvableTypeFromType = static_cast<Type*>(0); Q_UNUSED(resolvableTypeFromType);
+        FactoryBind(static_cast<ResolvableType*>(0)->staticMetaObject,
+                    [factory](DIContainer &ioc) -> QObject* { return factory(ioc); },
+                    isSingletonInstance);
+    }
+
+    //注册类型，并在编译期指定构造函数参数类型（单例），解析时直接 new Type(Resolve<Args>()...)
+    template <typename Type, typename... Args>
+    void BindCtor()
+    {
+        BindFactory<Type>(&DIContainer::construct<Type, Args...>, true);
+    }
+
+    //注册类型，并在编译期指定构造函数参数类型（瞬态）
+    template <typename Type, typename... Args>
+    void BindCtorTransient()
+    {
+        BindFactory<Type>(&DIContainer::construct<Type, Args...>, false);
+    }
+
     //注册键值和值（单例）
     void Bind(const QString &key, const QVariant &value)
     {
@@ -106,10 +142,46 @@ public:
         Collect0(value);
     }
 
+    //对象构造钩子：容器创建对象时把构造过程交给钩子执行，可用于统计构造耗时，传空函数取消
+    typedef std::function<void(const QString &typeName, bool isSingletonInstance, const std::function<void()> &construct)> ConstructionHook;
+    static void SetConstructionHook(ConstructionHook hook);
+
 private:
+    template <typename... Args>
+    struct TypeList {};
+
+    //依次解析构造函数参数，任一依赖解析失败则回收已解析的瞬态依赖，不创建对象
+    template <typename Type, typename... Args>
+    static Type* construct(DIContainer &ioc)
+    {
+        return constructNext<Type>(ioc, TypeList<Args...>());
+    }
+
+    template <typename Type, typename... Resolved>
+    static Type* constructNext(DIContainer &ioc, TypeList<>, Resolved*... resolved)
+    {
+        Q_UNUSED(ioc);
+        return new Type(resolved...);
+    }
+
+    template <typename Type, typename Next, typename... Rest, typename... Resolved>
+    static Type* constructNext(DIContainer &ioc, TypeList<Next, Rest...>, Resolved*... resolved)
+    {
+        Next *next = ioc.Resolve<Next>();
+        if (next == nullptr)
+        {
+            //单例不会被 Collect 回收
+            const int collected[] = { 0, (ioc.Collect(resolved), 0)... };
+            Q_UNUSED(collected);
+            return nullptr;
+        }
+        return constructNext<Type>(ioc, TypeList<Rest...>(), resolved..., next);
+    }
+
     void ClassBind(const QMetaObject &resolvableTypeMeta, const QMetaObject &typeMeta, bool isSingletonInstance);
     void ClassBind(const QMetaObject &typeMeta, bool isSingletonInstance);
     void ValueBind(const QString &key, const QVariant &value);
+    void FactoryBind(const QMetaObject &typeMeta, std::function<QObject*(DIContainer&)> factory, bool isSingletonInstance);
 
     void Collect0(QObject *value);
     void Collects0(size_t size, ...);
@@ -2,7 +2,7 @@
 using namespace Connector;
 
 
-ConnectorPair::ConnectorPair(QMetaObject metaObject1, QMetaObject metaObject2)
+ConnectorPair::ConnectorPair(const QMetaObject *metaObject1, const QMetaObject *metaObject2)
     :   _metaObject1(metaObject1)
     ,   _metaObject2(metaObject2)
 {
@@ -12,122 +12,123 @@ ConnectorPair::~ConnectorPair()
 {
     _objects1.clear();
     _objects2.clear();
+    _endpoints.clear();
+    _peers.clear();
     binding = nullptr;
     unbind = nullptr;
     match = nullptr;
 }
 
+bool ConnectorPair::accepts(const QMetaObject *metaObject) const
+{
+    return metaObject->inherits(_metaObject1) || metaObject->inherits(_metaObject2);
+}
+
 //加入集合，并调用绑定函数，符合要求返回true，否则为false
 bool ConnectorPair::Add(QObject *obj)
 {
     if (obj == nullptr)
         return false;
 
-    auto t = obj->metaObject()->className();
+    if (_endpoints.contains(obj))
+        return true;
 
-    if(t == _metaObject1.className()) {
-        if (_objects1.contains(obj))
-            return true;
+    auto metaObject = obj->metaObject();
+    //先按类型精确匹配，两端类型有继承关系时子类对象才能落到自己那一端
+    int side = 0;
+    if (metaObject == _metaObject1)
+        side = 1;
+    else if (metaObject == _metaObject2)
+        side = 2;
+    else if (metaObject->inherits(_metaObject1))
+        side = 1;
+    else if (metaObject->inherits(_metaObject2))
+        side = 2;
+    else
+        return false;
 
-        _objects1.append(obj);
-        connect(obj, &QObject::destroyed, this, &ConnectorPair::onViewModelDestroyed);
-        _names[obj] = QString::fromLatin1(t);
-        if(binding != nullptr) {
-            for (auto &obj2 : _objects2){
-                auto flag = true;
+    auto &objects = side == 1 ? _objects1 : _objects2;
+    const auto &others = side == 1 ? _objects2 : _objects1;
 
-                if (match != nullptr)
-                {
-                    flag = match(obj, obj2);
-                }
+    _endpoints.insert(obj, Endpoint{side, objects.size()});
+    objects.append(Handle{obj, QPointer<QObject>(obj)});
+    connect(obj, &QObject::destroyed, this, &ConnectorPair::onViewModelDestroyed);
 
-                if (flag){
-                    binding(obj, obj2);
-                }
-            }
-        }
-        return true;
-    }
-    else if(t == _metaObject2.className()) {
-        if (_objects2.contains(obj))
-            return true;
-
-        _objects2.append(obj);
-        connect(obj, &QObject::destroyed, this, &ConnectorPair::onViewModelDestroyed);
-        _names[obj] = QString::fromLatin1(t);
-        if(binding != nullptr) {
-            for (auto &obj1 : _objects1){
-                auto flag = true;
-
-                if (match != nullptr)
-                {
-                    flag = match(obj1, obj);
-                }
-
-                if (flag){
-                    binding(obj1, obj);
-                }
-            }
-        }
+    if (binding == nullptr && unbind == nullptr)
         return true;
+
+    for (const auto &handle : others) {
+        QObject *other = handle.object.data();
+        if (other == nullptr)
+            continue;
+
+        auto obj1 = side == 1 ? obj : other;
+        auto obj2 = side == 1 ? other : obj;
+
+        if (match != nullptr && !match(obj1, obj2))
+            continue;
+
+        _peers[obj].insert(other);
+        _peers[other].insert(obj);
+
+        if (binding != nullptr)
+            binding(obj1, obj2);
     }
-    return false;
+    return true;
 }
 
 bool ConnectorPair::Remove(QObject *obj)
 {
-    if(obj == nullptr || !_names.contains(obj))
+    if (obj == nullptr || !_endpoints.contains(obj))
         return false;
 
-    auto t = _names[obj];
-    _names.remove(obj);
-
-    if(t == QString::fromLatin1(_metaObject1.className())) {
-        if (!_objects1.contains(obj))
-            return false;
+    disconnect(obj, &QObject::destroyed, this, &ConnectorPair::onViewModelDestroyed);
 
-        if (unbind != nullptr)
-        {
-            for (auto &obj2 : _objects2)
-            {
-                auto flag = true;
+    //只解绑当初 match 通过并已绑定的对端，代价与绑定数量成正比
+    const auto peers = _peers.value(obj);
+    auto side = detach(obj);
 
-                if(match != nullptr)
-                    flag = match(obj, obj2);
-
-                if (flag)
-                    unbind(obj, obj2);
-
-            }
+    if (unbind != nullptr) {
+        for (auto other : peers) {
+            if (side == 1)
+                unbind(obj, other);
+            else
+                unbind(other, obj);
         }
-        _objects1.removeOne(obj);
-        return true;
     }
-    else if (t == QString::fromLatin1(_metaObject1.className())) {
-        if (!_objects2.contains(obj))
-            return false;
-        if (unbind != nullptr){
-            for (auto &obj1 : _objects1) {
-                auto flag = true;
-
-                if(match != nullptr)
-                    flag = match(obj1, obj);
-
-                if(flag)
-                    unbind(obj1, obj);
-            }
-        }
-        _objects2.removeOne(obj);
-        return true;
-    }
-    return false;
+    return true;
 }
 
 void ConnectorPair::onViewModelDestroyed(QObject *obj)
 {
-    if (_names.contains(obj)) {
-        _names.remove(obj);
+    //对象已析构，不能再调用解绑函数，只清理记录
+    if (_endpoints.contains(obj)) {
+        detach(obj);
+    }
+}
+
+int ConnectorPair::detach(QObject *obj)
+{
+    auto endpoint = _endpoints.take(obj);
+    auto &objects = endpoint.side == 1 ? _objects1 : _objects2;
+
+    int last = objects.size() - 1;
+    if (endpoint.slot != last) {
+        objects[endpoint.slot] = objects[last];
+        _endpoints[objects[endpoint.slot].key].slot = endpoint.slot;
     }
+    objects.removeLast();
+
+    const auto peers = _peers.take(obj);
+    for (auto other : peers) {
+        auto it = _peers.find(other);
+        if (it != _peers.end()) {
+            it.value().remove(obj);
+            if (it.value().isEmpty())
+                _peers.erase(it);
+        }
+    }
+    return endpoint.side;
 }
 
 IConnectorContainer::IConnectorContainer(QObject *parent)
@@ -143,18 +144,63 @@ IConnectorContainer::~IConnectorContainer()
 
 void IConnectorContainer::Add(QObject *obj)
 {
-    for(auto &v : _map)
+    if (obj == nullptr)
+        return;
+
+    //只处理与该类型相关的关系
+    const auto pairs = pairsOf(obj->metaObject());
+    if (pairs.isEmpty())
+        return;
+
+    //已加入的实体只加入之后才声明的关系
+    bool added = _objectPairs.contains(obj);
+    auto &joined = _objectPairs[obj];
+    for(auto &v : pairs)
     {
+        if (joined.contains(v))
+            continue;
+
         v->Add(obj);
+        joined.append(v);
     }
+
+    if (!added)
+        connect(obj, &QObject::destroyed, this, &IConnectorContainer::onObjectDestroyed);
 }
 
 void IConnectorContainer::Remove(QObject *obj)
 {
-    for(auto &v : _map)
+    //析构过程中 metaObject() 已不是原类型，按加入时记录的关系移除
+    if (obj == nullptr || !_objectPairs.contains(obj))
+        return;
+
+    const auto pairs = _objectPairs.take(obj);
+    for(auto &v : pairs)
     {
         v->Remove(obj);
     }
+    disconnect(obj, &QObject::destroyed, this, &IConnectorContainer::onObjectDestroyed);
+}
+
+QVector<ConnectorPair *> IConnectorContainer::pairsOf(const QMetaObject *metaObject)
+{
+    auto it = _index.constFind(metaObject);
+    if (it != _index.constEnd())
+        return it.value();
+
+    QVector<ConnectorPair *> pairs;
+    for(auto &v : _map)
+    {
+        if (v->accepts(metaObject))
+            pairs.append(v);
+    }
+    _index.insert(metaObject, pairs);
+    return pairs;
+}
+
+void IConnectorContainer::onObjectDestroyed(QObject *obj)
+{
+    _objectPairs.remove(obj);
 }
 
 DefaultConnectorContainer::DefaultConnectorContainer(QObject *parent)
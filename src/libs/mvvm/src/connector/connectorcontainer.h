@@ -3,6 +3,10 @@
 
 #include <QObject>
 #include <QList>
+#include <QHash>
+#include <QSet>
+#include <QPointer>
+#include <QVector>
 #include "../mvvm_global.h"
 #include "ioc.h"
 
@@ -20,9 +24,12 @@ namespace Connector {
         //匹配两者是否可以绑定（解绑）的函数 如果未nullptr 默认都需要绑定（解绑）
         std::function<bool(QObject *obj1, QObject *obj2)> match = nullptr;
 
-        ConnectorPair(QMetaObject metaObject1, QMetaObject metaObject2);
+        ConnectorPair(const QMetaObject *metaObject1, const QMetaObject *metaObject2);
         ~ConnectorPair();
 
+        //该类型（含子类）的对象是否属于这组关系
+        bool accepts(const QMetaObject *metaObject) const;
+
         //加入集合，并调用绑定函数，符合要求返回true，否则为false
         bool Add(QObject *obj);
         //移除集合，并调用解绑函数，符合要求返回true，否则为false
@@ -30,15 +37,29 @@ namespace Connector {
 
     private:
         void onViewModelDestroyed(QObject *obj = nullptr);
+        //从实体集合中摘除（末尾元素补位），并丢弃与对端的绑定记录，返回所在端
+        int detach(QObject *obj);
+
+        struct Endpoint {
+            int side;   //属于哪一端（1 或 2）
+            int slot;   //在该端实体集合中的位置
+        };
+
+        //实体的弱引用，key 仅用于查找记录，object 析构后自动置空
+        struct Handle {
+            QObject *key;
+            QPointer<QObject> object;
+        };
 
     private:
-        QMetaObject _metaObject1;   //QObject1原型
-        QMetaObject _metaObject2;   //QObject2原型
+        const QMetaObject *_metaObject1;   //QObject1原型
+        const QMetaObject *_metaObject2;   //QObject2原型
 
-        QList<QObject *> _objects1; //QObject1实体集合
-        QList<QObject *> _objects2; //QObject2实体集合
+        QVector<Handle> _objects1; //QObject1实体集合
+        QVector<Handle> _objects2; //QObject2实体集合
 
-        QHash<QObject*, QString> _names;
+        QHash<QObject *, Endpoint> _endpoints; //实体--所在端及位置
+        QHash<QObject *, QSet<QObject *>> _peers; //绑定时 match 通过的对端，解绑时直接使用
     };
 
 
@@ -56,19 +77,23 @@ namespace Connector {
                      std::function<bool(QObject *obj1, QObject *obj2)> unbindFunc = nullptr,
                      std::function<bool(QObject *obj1, QObject *obj2)> matchFunc = nullptr)
         {
-            auto metaObject1 = static_cast<T1*>(0)->staticMetaObject;
-            auto metaObject2 = static_cast<T2*>(0)->staticMetaObject;
-            auto pair = new ConnectorPair(metaObject1, metaObject2);
+            auto pair = new ConnectorPair(&T1::staticMetaObject, &T2::staticMetaObject);
             pair->binding = bindingFunc;
             pair->unbind = unbindFunc;
             pair->match = matchFunc;
             _map.append(pair);
+            _index.clear();//关系变化，类型索引失效
         }
 
         void Add(QObject *obj);
         void Remove(QObject *obj);
     private:
+        QVector<ConnectorPair *> pairsOf(const QMetaObject *metaObject);
+        void onObjectDestroyed(QObject *obj = nullptr);
+
         QList<ConnectorPair *> _map;
+        QHash<const QMetaObject *, QVector<ConnectorPair *>> _index; //类型--相关的关系
+        QHash<QObject *, QVector<ConnectorPair *>> _objectPairs; //已加入的实体--所在的关系
     };
 
     class MVVM_EXPORT DefaultConnectorContainer : public IConnectorContainer
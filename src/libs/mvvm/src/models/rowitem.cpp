@@ -1,10 +1,174 @@
 ﻿#include "rowitem.h"
 #include <QStack>
+#include <QMutex>
+#include <QMap>
+#include <QVector>
+#include <cstddef>
 #include "rowitemmodel.h"
 #include <QObject>
 
+namespace {
+/**
+ * @brief RowItem 的内存池，按块批量申请固定大小的节点，释放的节点放回所在块的空闲链表复用。
+ *        节点连续存放，省去每个节点的堆分配开销；块内节点全部释放后归还给系统，
+ *        只保留一个空块备用，避免在块边界反复申请释放。池本身不随程序退出析构，
+ *        以免静态对象析构顺序导致其后释放的节点失效
+ */
+class RowItemPool
+{
+public:
+    static RowItemPool *instance()
+    {
+        static RowItemPool *pool = new RowItemPool;
+        return pool;
+    }
+
+    static bool accepts(std::size_t size)
+    {
+        return size == sizeof(RowItem);
+    }
+
+    void *allocate()
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_available.isEmpty())
+        {
+            grow();
+        }
+
+        Chunk *chunk = m_available.last();
+        if (chunk->used++ == 0)
+        {
+            --m_emptyChunks;
+        }
+        FreeNode *node = chunk->freeList;
+        chunk->freeList = node->next;
+        if (chunk->freeList == Q_NULLPTR)
+        {
+            //块已用满，移出可分配列表
+            m_available.removeLast();
+            chunk->availableIndex = -1;
+        }
+        return node;
+    }
+
+    void deallocate(void *ptr)
+    {
+        QMutexLocker locker(&m_mutex);
+        //找到起始地址不大于 ptr 的最后一个块
+        auto it = m_chunks.upperBound(reinterpret_cast<quintptr>(ptr));
+        Q_ASSERT(it != m_chunks.begin());
+        Chunk *chunk = (--it).value();
+
+        FreeNode *node = static_cast<FreeNode *>(ptr);
+        node->next = chunk->freeList;
+        chunk->freeList = node;
+        if (chunk->availableIndex < 0)
+        {
+            chunk->availableIndex = m_available.size();
+            m_available.append(chunk);
+        }
+
+        if (--chunk->used == 0)
+        {
+            if (m_emptyChunks > 0)
+            {
+                release(chunk);
+            }
+            else
+            {
+                ++m_emptyChunks;
+            }
+        }
+    }
+
+private:
+    struct FreeNode
+    {
+        FreeNode *next;
+    };
+
+    struct Chunk
+    {
+        char *memory;
+        FreeNode *freeList;
+        int used;//已分配出去的节点数
+        int availableIndex;//在 m_available 中的位置，已用满时为 -1
+    };
+
+    //节点大小按最大对齐取整，保证块内每个节点都满足对齐要求
+    static const std::size_t NodeSize = (sizeof(RowItem) + alignof(std::max_align_t) - 1)
+                                        / alignof(std::max_align_t) * alignof(std::max_align_t);
+    static const int NodesPerChunk = 4096;
+
+    void grow()
+    {
+        Chunk *chunk = new Chunk;
+        chunk->memory = static_cast<char *>(::operator new(NodeSize * NodesPerChunk));
+        chunk->freeList = Q_NULLPTR;
+        chunk->used = 0;
+        for (int i = NodesPerChunk - 1; i >= 0; --i)
+        {
+            FreeNode *node = reinterpret_cast<FreeNode *>(chunk->memory + i * NodeSize);
+            node->next = chunk->freeList;
+            chunk->freeList = node;
+        }
+
+        chunk->availableIndex = m_available.size();
+        m_available.append(chunk);
+        m_chunks.insert(reinterpret_cast<quintptr>(chunk->memory), chunk);
+        ++m_emptyChunks;
+    }
+
+    void release(Chunk *chunk)
+    {
+        //用最后一个块填补空位，保持 m_available 紧凑
+        Chunk *last = m_available.takeLast();
+        if (last != chunk)
+        {
+            last->availableIndex = chunk->availableIndex;
+            m_available[chunk->availableIndex] = last;
+        }
+
+        m_chunks.remove(reinterpret_cast<quintptr>(chunk->memory));
+        ::operator delete(chunk->memory);
+        delete chunk;
+    }
+
+    QMutex m_mutex;
+    QMap<quintptr, Chunk *> m_chunks;//按起始地址排序的所有块，释放节点时据此找到所在块
+    QVector<Chunk *> m_available;//还有空闲节点的块
+    int m_emptyChunks = 0;//没有节点在用的块数，最多保留一个
+};
+}
+
+void *RowItem::operator new(std::size_t size)
+{
+    //派生类大小不同，仍走默认分配
+    if (!RowItemPool::accepts(size))
+    {
+        return ::operator new(size);
+    }
+    return RowItemPool::instance()->allocate();
+}
+
+void RowItem::operator delete(void *ptr, std::size_t size)
+{
+    if (ptr == Q_NULLPTR)
+    {
+        return;
+    }
+
+    if (!RowItemPool::accepts(size))
+    {
+        ::operator delete(ptr);
+        return;
+    }
+    RowItemPool::instance()->deallocate(ptr);
+}
+
 RowItem::RowItem(RowItemModel *rowItemModel, RowItem *parent)
-    : m_parent(parent), m_row(-1), m_model(rowItemModel)
+    : m_parent(Q_NULLPTR), m_row(-1), m_model(rowItemModel)
 {
     if(parent != Q_NULLPTR)
     {
@@ -15,91 +179,196 @@ RowItem::RowItem(RowItemModel *rowItemModel, RowItem *parent)
 RowItem::~RowItem()
 {
     removeChildren();
+    if (m_model != Q_NULLPTR)
+    {
+        m_model->itemDestroyed(this);
+    }
 }
 
 void RowItem::addChild(RowItem *item)
 {
-    if(item == Q_NULLPTR || m_children.contains(item))
+    //父项指针即可判断是否已是子项，无需遍历子项列表
+    if(item == Q_NULLPTR || item->m_parent == this)
     {
         return;
     }
 
+    //批量构建时或尚未关联模型（后台构建）时不发出信号，直接追加
+    if(m_model == Q_NULLPTR || m_model->isBulkLoading())
+    {
+        appendChildUnchecked(item);
+        return;
+    }
+
     int index = m_children.size();
-    m_model->beginInsertRows(m_model->indexFromItem(this), index, index);
+    m_model->beginInsertItems(this, index, index);
 
-    item->m_row = m_children.size();
-    m_children.append(item);
-    item->m_parent = this;
+    appendChildUnchecked(item);
 
-    m_model->endInsertRows();
+    m_model->endInsertItems();
 }
 
 void RowItem::insertChild(RowItem *item, int index)
 {
-    if (item == Q_NULLPTR || m_children.contains(item) || index < 0 || index > m_children.size())
+    insertChildren(index, QList<RowItem *>() << item);
+}
+
+void RowItem::insertChildren(int index, const QList<RowItem *> &items)
+{
+    if (index < 0 || index > m_children.size())
     {
         return;
     }
-    m_model->beginInsertRows(m_model->indexFromItem(this), index, index);
 
-    item->m_row = index;
-    m_children.insert(index, item);
-    item->m_parent = this;
+    //先把父项指向自己，列表中重复的项随即被过滤掉
+    QList<RowItem *> validItems;
+    validItems.reserve(items.size());
+    for (RowItem *item : items)
+    {
+        if (item != Q_NULLPTR && item->m_parent != this)
+        {
+            item->m_parent = this;
+            validItems.append(item);
+        }
+    }
+    if (validItems.isEmpty())
+    {
+        return;
+    }
 
-    int count = m_children.count();
-    for(int i = index + 1; i < count; i++)
+    if (m_model != Q_NULLPTR)
     {
-        this->child(i)->setRow(i);
+        m_model->beginInsertItems(this, index, index + validItems.size() - 1);
     }
 
-    m_model->endInsertRows();
+    if (index == m_children.size())
+    {
+        //末尾追加，已有子项的行号不变
+        m_children.reserve(m_children.size() + validItems.size());
+        for (RowItem *item : validItems)
+        {
+            appendChildUnchecked(item);
+        }
+    }
+    else
+    {
+        QList<RowItem *> children;
+        children.reserve(m_children.size() + validItems.size());
+        children << m_children.mid(0, index) << validItems << m_children.mid(index);
+        m_children.swap(children);
+        //插入的节点可能带着在别处的编号代数，恰好等于新代数时会返回旧行号
+        for (RowItem *item : validItems)
+        {
+            item->invalidateRow();
+        }
+        //后面的子项行号整体后移，留到下一次查询行号时统一重新编号
+        invalidateRows();
+    }
+
+    if (m_model != Q_NULLPTR)
+    {
+        m_model->endInsertItems();
+    }
 }
 
 void RowItem::removeChild(RowItem* item, bool deletePtr)
 {
-    if (item == Q_NULLPTR || !m_children.contains(item))
+    if (item == Q_NULLPTR || item->m_parent != this)
     {
         return;
     }
 
-    int index = item->row();
+    removeChildren(item->row(), 1, deletePtr);
+}
 
-    m_model->beginRemoveRows(m_model->indexFromItem(this), index, index);
+void RowItem::removeChild(int row, bool deletePtr)
+{
+    removeChildren(row, 1, deletePtr);
+}
 
-    m_children.removeOne(item);
-    if(deletePtr) {
-        delete item;
+void RowItem::removeChildren(int first, int count, bool deletePtr)
+{
+    if (first < 0 || count <= 0 || first + count > m_children.size())
+    {
+        return;
+    }
+
+    if (m_model != Q_NULLPTR)
+    {
+        m_model->beginRemoveItems(this, first, first + count - 1);
+    }
+
+    QList<RowItem *> removed = m_children.mid(first, count);
+    m_children.erase(m_children.begin() + first, m_children.begin() + first + count);
+
+    //只有删除的不是末尾时，后面子项的行号才会变化
+    if (first < m_children.size())
+    {
+        invalidateRows();
     }
 
-    int  count = childCount();
-    for(int i = index; i < count; i++)
+    for (RowItem *item : removed)
     {
-        this->child(i)->setRow(i);
+        if (deletePtr)
+        {
+            delete item;
+        }
+        else
+        {
+            item->m_parent = Q_NULLPTR;
+            item->invalidateRow();
+        }
+    }
+
+    if (m_model != Q_NULLPTR)
+    {
+        m_model->endRemoveItems();
     }
-    m_model->endRemoveRows();
 }
 
-void RowItem::removeChild(int row, bool deletePtr)
+int RowItem::row() const
 {
-    if (row < 0 || row >= m_children.size())
+    if (m_parent != Q_NULLPTR && m_rowGeneration != m_parent->m_childGeneration)
     {
-        m_children.removeAt(row);
+        m_parent->renumberChildren();
     }
+    return m_row;
+}
 
-    m_model->beginRemoveRows(m_model->indexFromItem(this), row, row);
-
-    RowItem *item = m_children.takeAt(row);
-    if(deletePtr) {
-        delete item;
+void RowItem::setRow(int row)
+{
+    m_row = row;
+    if (m_parent != Q_NULLPTR)
+    {
+        m_rowGeneration = m_parent->m_childGeneration;
     }
+}
 
-    int  count = childCount();
-    for(int i = row; i < count; i++)
+void RowItem::appendChildUnchecked(RowItem *item)
+{
+    item->m_parent = this;
+    item->m_row = m_children.size();
+    item->m_rowGeneration = m_childGeneration;
+    m_children.append(item);
+}
+
+void RowItem::renumberChildren() const
+{
+    int count = m_children.size();
+    for (int i = 0; i < count; i++)
     {
-        this->child(i)->setRow(i);
+        RowItem *item = m_children.at(i);
+        item->m_row = i;
+        item->m_rowGeneration = m_childGeneration;
     }
+}
 
-    m_model->endRemoveRows();
+void RowItem::invalidateRows()
+{
+    if (++m_childGeneration == InvalidGeneration)
+    {
+        m_childGeneration = 0;
+    }
 }
 
 void RowItem::removeChildren(bool deletePtr)
@@ -107,6 +376,14 @@ void RowItem::removeChildren(bool deletePtr)
     if(deletePtr) {
         qDeleteAll(m_children);
     }
+    else
+    {
+        for (RowItem *item : m_children)
+        {
+            item->m_parent = Q_NULLPTR;
+            item->invalidateRow();
+        }
+    }
     m_children.clear();
 }
 
@@ -152,9 +429,11 @@ int RowItem::level() const
         return 0;
     }
 
+    //未关联模型的节点以最上层的节点为根
+    RowItem *root = m_model == Q_NULLPTR ? Q_NULLPTR : m_model->root();
     int level = 1;
     RowItem *item = m_parent;
-    while (item != m_model->root())
+    while (item != root && item->m_parent != Q_NULLPTR)
     {
         level++;
         item = item->parent();
@@ -163,49 +442,65 @@ int RowItem::level() const
 }
 void RowItem::setItemData(const QVariantList &list)
 {
-    m_data = list;
+    m_data.clear();
+    m_data.reserve(list.size());
+    for (const QVariant &value : list)
+    {
+        m_data.append(value);
+    }
 
-    QModelIndex topLeft = m_model->createIndex(m_row, 0, this);
-    int acolumn = m_model->columnCount() - 1;
-    QModelIndex bottomRight = m_model->createIndex(m_row, acolumn, this);
-    emit  m_model->dataChanged(topLeft, bottomRight, QVector<int>({Qt::DisplayRole,Qt::EditRole}));
+    if (m_model != Q_NULLPTR)
+    {
+        m_model->itemDataChanged(this);
+    }
 }
 
 void RowItem::setItemData(const QObject &entity)
 {
-    QVariantList list;
-    foreach(auto key, m_model->m_headerKeys)
+    //表头字段由模型提供，未关联模型时由 RowItemBuilder 转换成列表再设置
+    if (m_model == Q_NULLPTR)
+    {
+        return;
+    }
+
+    const QList<QByteArray> &propertyNames = m_model->m_headerPropertyNames;
+    m_data.clear();
+    m_data.reserve(propertyNames.size());
+    for (const QByteArray &name : propertyNames)
     {
-        auto kv = key.toLocal8Bit();
-        auto value = entity.property(kv);
-        list << value;
+        m_data.append(entity.property(name.constData()));
     }
-    m_data = list;
 
-    QModelIndex topLeft = m_model->createIndex(m_row, 0, this);
-    int acolumn = m_model->columnCount() - 1;
-    QModelIndex bottomRight = m_model->createIndex(m_row, acolumn, this);
-    emit  m_model->dataChanged(topLeft, bottomRight, QVector<int>({Qt::DisplayRole,Qt::EditRole}));
+    m_model->itemDataChanged(this);
 }
 
 void RowItem::setItemData(const QVariantMap &map)
 {
-    QVariantList list;
-    foreach(auto key, m_model->m_headerKeys)
+    if (m_model == Q_NULLPTR)
+    {
+        return;
+    }
+
+    const QStringList &headerKeys = m_model->m_headerKeys;
+    m_data.clear();
+    m_data.reserve(headerKeys.size());
+    foreach(auto key, headerKeys)
     {
-        list << map.value(key);
+        m_data.append(map.value(key));
     }
-    m_data = list;
 
-    QModelIndex topLeft = m_model->createIndex(m_row, 0, this);
-    int acolumn = m_model->columnCount() - 1;
-    QModelIndex bottomRight = m_model->createIndex(m_row, acolumn, this);
-    emit  m_model->dataChanged(topLeft, bottomRight, QVector<int>({Qt::DisplayRole,Qt::EditRole}));
+    m_model->itemDataChanged(this);
 }
 
 QVariantList RowItem::itemDataList() const
 {
-    return m_data;
+    QVariantList list;
+    list.reserve(m_data.size());
+    for (const QVariant &value : m_data)
+    {
+        list.append(value);
+    }
+    return list;
 }
 
 void RowItem::setBackgroundColor(const QColor &color)
@@ -228,6 +523,11 @@ QColor RowItem::backgroundColor() const
 QVariantMap RowItem::itemDataMap() const
 {
     QVariantMap result;
+    if (m_model == Q_NULLPTR)
+    {
+        return result;
+    }
+
     const QStringList &headerKeys = m_model->m_headerKeys;
 
     for (int i = 0; i < headerKeys.size(); i++)
@@ -241,34 +541,41 @@ QVariantMap RowItem::itemDataMap() const
 
 QVariant RowItem::value(const QString &headerKey) const
 {
-    int index = m_model->m_headerKeys.indexOf(headerKey);
-    if (index < 0 || index > m_data.size())
+    return m_model == Q_NULLPTR ? QVariant() : value(m_model->headerIndex(headerKey));
+}
+
+QVariant RowItem::value(int column) const
+{
+    if (column < 0 || column >= m_data.size())
     {
         return QVariant();
     }
 
-    return m_data.at(index);
+    return m_data.at(column);
 }
 
 void RowItem::setValue(const QString &key, const QVariant &value)
 {
-    if(m_data.isEmpty())
+    if (m_model != Q_NULLPTR)
     {
-        return;
+        setValue(m_model->headerIndex(key), value);
     }
+}
 
-    int index = m_model->m_headerKeys.indexOf(key);
-    if (index < 0)
+void RowItem::setValue(int column, const QVariant &value)
+{
+    if (column < 0 || column >= m_data.size())
     {
         return ;
     }
 
-    m_data.replace(index, value);
+    m_data.replace(column, value);
 
-    QModelIndex topLeft = m_model->createIndex(m_row, 0, this);
-    int acolumn = m_model->columnCount() - 1;
-    QModelIndex bottomRight = m_model->createIndex(m_row, acolumn, this);
-    emit m_model->dataChanged(topLeft, bottomRight, QVector<int>({Qt::DisplayRole,Qt::EditRole}));
+    //只记下这一列，由模型合并后统一通知
+    if (m_model != Q_NULLPTR)
+    {
+        m_model->itemColumnsChanged(this, column, column);
+    }
 }
 
 void RowItem::setModel(RowItemModel *model)
@@ -16,6 +16,8 @@
 #include <QVariant>
 #include <QList>
 #include <QColor>
+#include <QVector>
+#include <cstddef>
 #include "../mvvm_global.h"
 
 class RowItemModel;
@@ -32,6 +34,12 @@ public:
     explicit RowItem(RowItemModel *rowItemModel, RowItem *parent = nullptr);
     virtual ~RowItem();
 
+    /**
+     * @brief 节点从内存池中分配，大量节点时减少堆分配次数并使节点在内存中连续
+     */
+    static void *operator new(std::size_t size);
+    static void operator delete(void *ptr, std::size_t size);
+
     /**
      * @brief 添加子项（在末尾添加子项）
      */
@@ -42,6 +50,11 @@ public:
      */
     void insertChild(RowItem *item, int index);
 
+    /**
+     * @brief 添加多个子项（指定位置索引），只发出一次插入信号
+     */
+    void insertChildren(int index, const QList<RowItem *> &items);
+
     /**
      * @brief 删除子项，默认析构指针
      */
@@ -52,6 +65,11 @@ public:
      */
     void removeChild(int row, bool deletePtr = true);
 
+    /**
+     * @brief 删除从 first 开始的 count 个子项，只发出一次删除信号，默认析构指针
+     */
+    void removeChildren(int first, int count, bool deletePtr = true);
+
     /**
      * @brief 清空所有子项，默认析构指针
      */
@@ -91,11 +109,11 @@ public:
     /**
      * @brief 保存该节点是其父项的第几个子项，查询优化所用
      */
-    void setRow(int row) { m_row = row; }
+    void setRow(int row);
     /**
-     * @brief 返回本节点位于父项下第几个子项
+     * @brief 返回本节点位于父项下第几个子项。插入删除后行号延迟到查询时统一重新编号
      */
-    int row() const { return m_row; }
+    int row() const;
 
     /**
      * @brief 返回本节点处于树的层级,从 1 开始
@@ -132,11 +150,21 @@ public:
      */
     QVariant value(const QString &headerKey) const;
 
+    /**
+     * @brief 根据列索引从 Item 中取出数据，列索引可预先通过 RowItemModel::headerIndex 取得
+     */
+    QVariant value(int column) const;
+
     /**
      * @brief 根据字段名将数据存入 Item
      */
     void setValue(const QString &key, const QVariant &value);
 
+    /**
+     * @brief 根据列索引将数据存入 Item。数据变化不会立即通知视图，见 RowItemModel::flushChanges
+     */
+    void setValue(int column, const QVariant &value);
+
     /**
      * @brief 设置背景颜色
      */
@@ -152,18 +180,43 @@ public:
 private:
 
     /**
-     * @brief   给 Item 和它的孩子们设置 model
+     * @brief   给 Item 和它的孩子们设置 model。model 可为空，此时节点不发出任何通知，
+     *          可在工作线程中构建，见 RowItemBuilder
      */
     void setModel(RowItemModel *model);
 
+    /**
+     * @brief   不做检查直接在末尾追加子项
+     */
+    void appendChildUnchecked(RowItem *item);
+
+    /**
+     * @brief   按子项当前位置重新编号
+     */
+    void renumberChildren() const;
+
+    /**
+     * @brief   子项位置整体变化，行号留到下一次查询时统一重新编号
+     */
+    void invalidateRows();
+
+    /**
+     * @brief   使单个节点的行号失效，节点脱离父项或插入到中间时使用
+     */
+    void invalidateRow() const { m_rowGeneration = InvalidGeneration; }
+
+    static const quint32 InvalidGeneration = 0xFFFFFFFF;// 失效的编号代数，子项编号代数不会取到该值
+
 
 private:
     QList<RowItem *> m_children;// 子项
     RowItem *m_parent;// 父项
 
     QColor m_color;// 背景颜色
-    int m_row;// 此item位于父项中第几个
-    QVariantList m_data;// 存储的数据
+    mutable int m_row;// 此item位于父项中第几个
+    mutable quint32 m_rowGeneration = 0;// m_row 对应的父项子项编号代数
+    quint32 m_childGeneration = 0;// 子项编号代数，子项位置整体变化时递增
+    QVector<QVariant> m_data;// 存储的数据，单元格连续存放，不再逐个单独分配
     RowItemModel *m_model; //绑定的 Model
     friend class RowItemModel;
 
@@ -0,0 +1,115 @@
+#include "rowitembuilder.h"
+#include "rowitem.h"
+
+#include <QHash>
+
+RowItemBuilder::RowItemBuilder(const QStringList &headerKeys)
+    : m_headerKeys(headerKeys)
+{
+    m_propertyNames.reserve(headerKeys.size());
+    for (const QString &key : headerKeys)
+    {
+        m_propertyNames.append(key.toLocal8Bit());
+    }
+    m_rootItem = new RowItem(Q_NULLPTR);
+}
+
+RowItemBuilder::~RowItemBuilder()
+{
+    delete m_rootItem;
+}
+
+RowItem *RowItemBuilder::addRow(const QVariantList &row, RowItem *parent)
+{
+    RowItem *item = new RowItem(Q_NULLPTR);
+    item->setItemData(row);
+    (parent == Q_NULLPTR ? m_rootItem : parent)->addChild(item);
+    return item;
+}
+
+RowItem *RowItemBuilder::addRow(const QVariantMap &map, RowItem *parent)
+{
+    QVariantList row;
+    row.reserve(m_headerKeys.size());
+    for (const QString &key : m_headerKeys)
+    {
+        row.append(map.value(key));
+    }
+    return addRow(row, parent);
+}
+
+RowItem *RowItemBuilder::addRow(const QObject &entity, RowItem *parent)
+{
+    QVariantList row;
+    row.reserve(m_propertyNames.size());
+    for (const QByteArray &name : m_propertyNames)
+    {
+        row.append(entity.property(name.constData()));
+    }
+    return addRow(row, parent);
+}
+
+void RowItemBuilder::addRows(const QList<QVariantList> &rows, RowItem *parent)
+{
+    for (const QVariantList &row : rows)
+    {
+        addRow(row, parent);
+    }
+}
+
+void RowItemBuilder::buildTree(const QList<QVariantList> &source, int idIndex, int pidIndex, int rootId)
+{
+    int size = source.size();
+
+    //根节点默认为结果集第一行，不在第一行时先找根节点
+    int rootIndex = 0;
+    if (rootId != -1)
+    {
+        for (; rootIndex < size; rootIndex++)
+        {
+            if (source.at(rootIndex).at(idIndex) == rootId)
+            {
+                break;
+            }
+        }
+    }
+    if (rootIndex >= size)
+    {
+        return;
+    }
+
+    QHash<int, RowItem *> items; //存放树节点的id和对应的 Item
+    const QVariantList &rootRow = source.at(rootIndex);
+    RowItem *parentItem = addRow(rootRow);
+    int parentId = rootRow.at(idIndex).toInt();
+    items.insert(parentId, parentItem);
+
+    for (int i = rootIndex + 1; i < size; i++)
+    {
+        const QVariantList &row = source.at(i);
+        if (parentId != row.at(pidIndex).toInt())
+        {
+            parentId = row.at(pidIndex).toInt();
+            parentItem = items.value(parentId);
+        }
+        //处理脏数据
+        if (parentItem == Q_NULLPTR)
+        {
+            continue;
+        }
+
+        items.insert(row.at(idIndex).toInt(), addRow(row, parentItem));
+    }
+}
+
+QList<RowItem *> RowItemBuilder::items() const
+{
+    return m_rootItem->children();
+}
+
+QList<RowItem *> RowItemBuilder::takeItems()
+{
+    QList<RowItem *> items = m_rootItem->children();
+    m_rootItem->removeChildren(0, items.size(), false);
+    return items;
+}
@@ -0,0 +1,91 @@
+/******************************************************************************
+ *
+ * @file       rowitembuilder.h
+ * @brief      在工作线程中构建 RowItem 子树，构建完成后一次挂到 RowItemModel 上
+ *
+ * @author     lzx
+ * @date       2021/09/29
+ *
+ * @history
+ *****************************************************************************/
+
+#ifndef ROWITEMBUILDER_H
+#define ROWITEMBUILDER_H
+
+#include <QObject>
+#include <QVariant>
+#include <QList>
+#include <QStringList>
+#include "../mvvm_global.h"
+
+class RowItem;
+
+/**
+ * @brief 构建不关联模型的 RowItem 子树。构建过程不访问任何模型，可以放在工作线程中执行，
+ *        完成后在模型所在线程通过 RowItemModel::attachItems 挂到树上，只发出一次插入信号。
+ *        一般直接使用 RowItemModel::populateAsync：
+ *
+ *      model->populateAsync([](RowItemBuilder &builder) {
+ *          DBUtil db;
+ *          builder.addRows(db.selectLists(SqlHandler::instance().getSql("User", "findAll")));
+ *      });
+ *
+ *        一个构建器同时只能在一个线程中使用
+ */
+class MVVM_EXPORT RowItemBuilder
+{
+public:
+    /**
+     * @brief headerKeys 为表头字段，从 map 或对象取值时按它排列各列，一般取 RowItemModel::headerKeys
+     */
+    explicit RowItemBuilder(const QStringList &headerKeys = QStringList());
+
+    /**
+     * @brief 删除尚未取走的节点
+     */
+    ~RowItemBuilder();
+
+    /**
+     * @brief 在 parent 下追加一行，parent 为空时追加为顶层节点。返回新节点
+     */
+    RowItem *addRow(const QVariantList &row, RowItem *parent = nullptr);
+
+    /**
+     * @brief 按表头字段从 map 中取值，追加一行
+     */
+    RowItem *addRow(const QVariantMap &map, RowItem *parent = nullptr);
+
+    /**
+     * @brief 按表头字段从对象的属性中取值，追加一行
+     */
+    RowItem *addRow(const QObject &entity, RowItem *parent = nullptr);
+
+    /**
+     * @brief 在 parent 下追加多行
+     */
+    void addRows(const QList<QVariantList> &rows, RowItem *parent = nullptr);
+
+    /**
+     * @brief 构造节点为{id, pid}类型的树，规则与 RowItemModel::constructTree 相同
+     */
+    void buildTree(const QList<QVariantList> &source, int idIndex, int pidIndex, int rootId = -1);
+
+    /**
+     * @brief 顶层节点
+     */
+    QList<RowItem *> items() const;
+
+    /**
+     * @brief 取走顶层节点，之后由调用方（一般是 RowItemModel::attachItems）负责释放
+     */
+    QList<RowItem *> takeItems();
+
+private:
+    QStringList m_headerKeys; //表头字段
+    QList<QByteArray> m_propertyNames; //表头字段对应的属性名
+    RowItem *m_rootItem; //顶层节点的容器，不属于任何模型
+
+    Q_DISABLE_COPY(RowItemBuilder)
+};
+
+#endif // ROWITEMBUILDER_H
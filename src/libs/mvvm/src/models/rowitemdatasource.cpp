@@ -0,0 +1,39 @@
+#include "rowitemdatasource.h"
+
+RowItemDataSource::~RowItemDataSource()
+{
+
+}
+
+int RowItemDataSource::pageSize() const
+{
+    return 200;
+}
+
+bool RowItemDataSource::hasChildren(const RowItem *parentItem) const
+{
+    return parentItem == Q_NULLPTR;
+}
+
+int FunctionRowItemDataSource::pageSize() const
+{
+    return rows;
+}
+
+QList<QVariantList> FunctionRowItemDataSource::fetch(const QVariantList &parentRow, int offset, int limit)
+{
+    if (fetchFunc == nullptr)
+    {
+        return QList<QVariantList>();
+    }
+    return fetchFunc(parentRow, offset, limit);
+}
+
+bool FunctionRowItemDataSource::hasChildren(const RowItem *parentItem) const
+{
+    if (hasChildrenFunc == nullptr)
+    {
+        return RowItemDataSource::hasChildren(parentItem);
+    }
+    return hasChildrenFunc(parentItem);
+}
@@ -0,0 +1,73 @@
+/******************************************************************************
+ *
+ * @file       rowitemdatasource.h
+ * @brief      RowItemModel 的分页数据源，用于按需加载子项数据
+ *
+ * @author     lzx
+ * @date       2021/09/29
+ *
+ * @history
+ *****************************************************************************/
+
+#ifndef ROWITEMDATASOURCE_H
+#define ROWITEMDATASOURCE_H
+
+#include <QVariant>
+#include <QList>
+#include <functional>
+#include "../mvvm_global.h"
+
+class RowItem;
+
+/**
+ * @brief 分页数据源，RowItemModel 通过 canFetchMore/fetchMore 按页向其取数据。
+ *        fetch 会在工作线程中调用以预取下一页，实现需保证线程安全
+ */
+class MVVM_EXPORT RowItemDataSource
+{
+public:
+    virtual ~RowItemDataSource();
+
+    /**
+     * @brief 每页的行数
+     */
+    virtual int pageSize() const;
+
+    /**
+     * @brief 取父节点下从 offset 开始的最多 limit 行数据。parentRow 为父节点的数据，根节点时为空
+     */
+    virtual QList<QVariantList> fetch(const QVariantList &parentRow, int offset, int limit) = 0;
+
+    /**
+     * @brief 父节点下是否可能有子项，默认只有根节点有（即表格）。parentItem 为空表示根节点。
+     *        视图绘制每一行时都会调用，实现应直接用 RowItem::value 读取所需的列，避免复制整行数据
+     */
+    virtual bool hasChildren(const RowItem *parentItem) const;
+};
+
+/**
+ * @brief 通过函数提供数据的分页数据源。例如用 DBUtil 按 SQL id 分页查询：
+ *
+ *      auto source = QSharedPointer<FunctionRowItemDataSource>::create();
+ *      source->fetchFunc = [](const QVariantList &parentRow, int offset, int limit) {
+ *          QVariantMap params;
+ *          params["offset"] = offset;
+ *          params["limit"]  = limit;
+ *          DBUtil db;
+ *          return db.selectLists(SqlHandler::instance().getSql("User", "findPage"), params);
+ *      };
+ *      model->setDataSource(source);
+ */
+class MVVM_EXPORT FunctionRowItemDataSource : public RowItemDataSource
+{
+public:
+    int pageSize() const override;
+    QList<QVariantList> fetch(const QVariantList &parentRow, int offset, int limit) override;
+    bool hasChildren(const RowItem *parentItem) const override;
+
+    int rows = 200;//每页的行数
+    std::function<QList<QVariantList>(const QVariantList &parentRow, int offset, int limit)> fetchFunc = nullptr;//取数据的函数
+    std::function<bool(const RowItem *parentItem)> hasChildrenFunc = nullptr;//判断是否有子项的函数，为 nullptr 时只有根节点有
+};
+
+#endif // ROWITEMDATASOURCE_H
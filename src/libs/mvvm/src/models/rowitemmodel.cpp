@@ -1,5 +1,123 @@
 ﻿#include "rowitemmodel.h"
 #include "rowitem.h"
+#include "rowitembuilder.h"
+#include "rowitemdatasource.h"
+
+#include <QDateTime>
+#include <QFutureWatcher>
+#include <QSet>
+#include <QThread>
+#include <QTimer>
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtConcurrent/QtConcurrentRun>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+namespace {
+//超过这个行数时分段并行排序
+const int ParallelSortThreshold = 50000;
+//排序过滤时一次增删超过这个行数，逐段发出行信号不如整体重置
+const int ViewRowsNotifyThreshold = 1000;
+//刷新快照时增删的段数超过这个值，逐段通知不如整体重置
+const int SnapshotRunsThreshold = 256;
+
+//排序键：空值在前，其次数值，最后字符串
+struct SortKey
+{
+    enum Kind
+    {
+        Null,
+        Number,
+        Text
+    };
+
+    Kind kind = Null;
+    double number = 0;
+    QString text;
+};
+
+SortKey makeSortKey(const QVariant &value)
+{
+    SortKey key;
+    switch (value.userType())
+    {
+    case QMetaType::Bool:
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::Short:
+    case QMetaType::UShort:
+    case QMetaType::Long:
+    case QMetaType::ULong:
+    case QMetaType::LongLong:
+    case QMetaType::ULongLong:
+    case QMetaType::Float:
+    case QMetaType::Double:
+        key.kind = SortKey::Number;
+        key.number = value.toDouble();
+        break;
+    case QMetaType::QDate:
+        key.kind = SortKey::Number;
+        key.number = value.toDate().toJulianDay();
+        break;
+    case QMetaType::QTime:
+        key.kind = SortKey::Number;
+        key.number = value.toTime().msecsSinceStartOfDay();
+        break;
+    case QMetaType::QDateTime:
+        key.kind = SortKey::Number;
+        key.number = value.toDateTime().toMSecsSinceEpoch();
+        break;
+    default:
+        if (!value.isNull())
+        {
+            key.kind = SortKey::Text;
+            key.text = value.toString();
+        }
+        break;
+    }
+    return key;
+}
+
+int compareSortKey(const SortKey &left, const SortKey &right)
+{
+    if (left.kind != right.kind)
+    {
+        return left.kind < right.kind ? -1 : 1;
+    }
+
+    switch (left.kind)
+    {
+    case SortKey::Number:
+    {
+        //NaN 与任何数比较都不成立，单独排在所有数值之后，保证排序的严格弱序
+        const bool leftNaN = std::isnan(left.number);
+        const bool rightNaN = std::isnan(right.number);
+        if (leftNaN || rightNaN)
+        {
+            return leftNaN == rightNaN ? 0 : (leftNaN ? 1 : -1);
+        }
+        return left.number < right.number ? -1 : (right.number < left.number ? 1 : 0);
+    }
+    case SortKey::Text:
+        return left.text.compare(right.text);
+    default:
+        return 0;
+    }
+}
+
+//把 [0, count) 平均分成若干段
+QVector<QPair<int, int>> splitRanges(int count, int parts)
+{
+    QVector<QPair<int, int>> ranges;
+    int step = qMax(1, (count + parts - 1) / parts);
+    for (int begin = 0; begin < count; begin += step)
+    {
+        ranges.append(qMakePair(begin, qMin(count, begin + step)));
+    }
+    return ranges;
+}
+}
 
 RowItemModel::RowItemModel(QObject *parent)
     : QAbstractItemModel(parent)
@@ -18,6 +136,9 @@ RowItemModel::RowItemModel(const QStringList& headers, QObject *parent)
 
 RowItemModel::~RowItemModel()
 {
+    m_dataSource.clear();
+    m_fetchStates.clear();
+    m_pendingChanges.clear();
     m_rootItem->removeChildren();
     delete m_rootItem;
 }
@@ -62,13 +183,14 @@ QVariant RowItemModel::data(const QModelIndex &index, int role) const
     {
         int column = index.column();
         QVariant data = item->data(column, role);
-        if (!m_relationMaps.contains(column))
+        const RelationTable *table = role == Qt::BackgroundRole ? Q_NULLPTR : relationTable(column);
+        if (table == Q_NULLPTR)
         {
             return data;
         }
         else
         {
-            return m_relationMaps.value(column).value(data.toString());
+            return table->translate(data);
         }
     }
     return QVariant();
@@ -85,28 +207,32 @@ bool RowItemModel::setData(const QModelIndex &index, const QVariant &value, int
     RowItem *item = itemFromIndex(index);
 
     int column = index.column();
-    if (!m_relationMaps.contains(column))
+    const RelationTable *table = role == Qt::BackgroundRole ? Q_NULLPTR : relationTable(column);
+    if (table == Q_NULLPTR)
     {
         item->setData(column, value, role);
     }
     else
     {
-        item->setData(column, m_relationMaps.value(column).key(value), role);
+        item->setData(column, table->code(value), role);
     }
 
     QVector<int> roles((role == Qt::DisplayRole) ?
                            QVector<int>({Qt::DisplayRole, Qt::EditRole}) :
                            QVector<int>({role}));
 
-    //发出信号 通知 data函数重新读取数据
+    //发出信号 通知 data函数重新读取数据，背景色一般是批量设置的，合并后再发出
     if(role == Qt::BackgroundRole)
     {
-        emit dataChanged(createIndex(item->row(), 0, item),
-                         createIndex(item->row(), columnCount() - 1, item), roles);
+        itemColumnsChanged(item, 0, columnCount() - 1, BackgroundChange);
     }
     else
     {
         emit dataChanged(index, index, roles);
+        if (m_viewActive && item->parent() == m_rootItem)
+        {
+            refilterItem(item);
+        }
     }
 
     return true;
@@ -129,7 +255,7 @@ QModelIndex RowItemModel::index(int row, int column, const QModelIndex &parent)
         return QModelIndex();
 
     RowItem *parentItem = itemFromIndex(parent);
-    RowItem *item = parentItem->child(row);
+    RowItem *item = childAt(parentItem, row);
     if (item)
         return createIndex(row, column, item);
     else
@@ -149,7 +275,142 @@ QModelIndex RowItemModel::parent(const QModelIndex &index) const
         return QModelIndex();
     }
 
-    return createIndex(parentItem->row(), 0, parentItem);
+    return createIndex(rowOf(parentItem), 0, parentItem);
+}
+
+bool RowItemModel::hasChildren(const QModelIndex &parent) const
+{
+    if (m_dataSource.isNull())
+    {
+        return QAbstractItemModel::hasChildren(parent);
+    }
+
+    if (parent.column() > 0)
+    {
+        return false;
+    }
+
+    RowItem *item = itemFromIndex(parent);
+    if (item->childCount() > 0)
+    {
+        return true;
+    }
+
+    auto state = m_fetchStates.constFind(item);
+    if (state != m_fetchStates.constEnd() && state.value().finished)
+    {
+        return false;
+    }
+
+    return item == m_rootItem || m_dataSource->hasChildren(item);
+}
+
+bool RowItemModel::canFetchMore(const QModelIndex &parent) const
+{
+    if (m_dataSource.isNull() || parent.column() > 0)
+    {
+        return false;
+    }
+
+    RowItem *item = itemFromIndex(parent);
+    auto state = m_fetchStates.constFind(item);
+    if (state != m_fetchStates.constEnd())
+    {
+        return !state.value().finished;
+    }
+
+    return item == m_rootItem || m_dataSource->hasChildren(item);
+}
+
+void RowItemModel::fetchMore(const QModelIndex &parent)
+{
+    if (!canFetchMore(parent))
+    {
+        return;
+    }
+
+    fetchItem(itemFromIndex(parent));
+}
+
+void RowItemModel::fetchItem(RowItem *item)
+{
+    int pageSize = qMax(1, m_dataSource->pageSize());
+
+    //优先使用后台预取好的一页，预取未完成时等完成后再插入，没有预取时同步取
+    QList<QVariantList> rows;
+    FetchState &state = m_fetchStates[item];
+    if (state.prefetch != Q_NULLPTR)
+    {
+        if (!state.prefetch->isFinished())
+        {
+            state.waiting = true;
+            return;
+        }
+
+        rows = state.prefetch->result();
+        state.prefetch->deleteLater();
+        state.prefetch = Q_NULLPTR;
+        state.waiting = false;
+    }
+    else
+    {
+        rows = m_dataSource->fetch(item == m_rootItem ? QVariantList() : item->itemDataList(),
+                                   state.fetched, pageSize);
+    }
+
+    state.fetched += rows.size();
+    state.finished = rows.size() < pageSize;
+
+    if (!state.finished)
+    {
+        //数据源随 lambda 一起持有，模型清空或更换数据源后预取结果直接丢弃
+        QSharedPointer<RowItemDataSource> dataSource = m_dataSource;
+        QVariantList parentRow = item == m_rootItem ? QVariantList() : item->itemDataList();
+        int offset = state.fetched;
+        QFutureWatcher<QList<QVariantList>> *watcher = new QFutureWatcher<QList<QVariantList>>(this);
+        connect(watcher, &QFutureWatcher<QList<QVariantList>>::finished, this, [this, item, watcher]() {
+            prefetchFinished(item, watcher);
+        });
+        watcher->setFuture(QtConcurrent::run([dataSource, parentRow, offset, pageSize]() {
+            return dataSource->fetch(parentRow, offset, pageSize);
+        }));
+        state.prefetch = watcher;
+    }
+
+    //state 引用在插入后可能失效，插入放在最后
+    if (!rows.isEmpty())
+    {
+        appendItems(item, rows);
+    }
+}
+
+void RowItemModel::prefetchFinished(RowItem *item, QFutureWatcher<QList<QVariantList>> *watcher)
+{
+    //节点已删除、模型已清空或节点地址被新节点复用时，状态中不再是这个预取
+    auto state = m_fetchStates.find(item);
+    if (state == m_fetchStates.end() || state.value().prefetch != watcher)
+    {
+        watcher->deleteLater();
+        return;
+    }
+
+    if (state.value().waiting)
+    {
+        fetchItem(item);
+    }
+}
+
+void RowItemModel::clearFetchStates()
+{
+    //未完成的预取在完成时发现状态已不在也会释放，这里统一提前释放
+    for (auto it = m_fetchStates.constBegin(); it != m_fetchStates.constEnd(); ++it)
+    {
+        if (it.value().prefetch != Q_NULLPTR)
+        {
+            it.value().prefetch->deleteLater();
+        }
+    }
+    m_fetchStates.clear();
 }
 
 int RowItemModel::rowCount(const QModelIndex &parent) const
@@ -158,6 +419,10 @@ int RowItemModel::rowCount(const QModelIndex &parent) const
         return 0;
 
     RowItem* item = itemFromIndex(parent);
+    if (m_viewActive && item == m_rootItem)
+    {
+        return m_viewRows.size();
+    }
     return item->childCount();
 }
 
@@ -169,8 +434,8 @@ int RowItemModel::columnCount(const QModelIndex &parent) const
 
 QModelIndex RowItemModel::indexFromItem(RowItem *item) const
 {
-    if (item != Q_NULLPTR && item->parent() != Q_NULLPTR) {
-        return createIndex(item->row(), 0, item);
+    if (item != Q_NULLPTR && item->parent() != Q_NULLPTR && isItemVisible(item)) {
+        return createIndex(rowOf(item), 0, item);
     }
     return QModelIndex();
 }
@@ -180,6 +445,9 @@ void RowItemModel::clear()
     beginResetModel();
 
     m_rootItem->removeChildren();
+    clearFetchStates();
+    m_pendingChanges.clear();
+    rebuildView();
 
     endResetModel();
 }
@@ -198,37 +466,62 @@ bool RowItemModel::insertRows(int row, int count, const QModelIndex &parent)
 {
     if (row < 0 || row > rowCount(parent) || count <= 0)
     {
-        return true;
+        return false;
     }
 
-    beginInsertRows(parent, row, row + count -1);
-
     RowItem* parentItem = itemFromIndex(parent);
+    int columns = qMax(columnCount(), m_headerKeys.size());
+
+    QList<RowItem *> items;
+    items.reserve(count);
     for(int i =  0; i < count; i++)
     {
-        new RowItem(this, parentItem);
+        RowItem *item = new RowItem(this);
+        item->m_data.resize(columns);
+        items.append(item);
+    }
+
+    //排序过滤时 row 是显示位置，插在它当前对应的行之前，新行显示在 row 处，不按排序过滤放置
+    if (m_viewActive && parentItem == m_rootItem)
+    {
+        m_insertViewRow = row;
+        row = row < m_viewRows.size() ? m_viewRows.at(row) : parentItem->childCount();
+        parentItem->insertChildren(row, items);
+        m_insertViewRow = -1;
+        return true;
     }
 
-    endInsertRows();
+    parentItem->insertChildren(row, items);
     return true;
 }
 bool RowItemModel::removeRows(int row, int count, const QModelIndex &parent)
 {
     int rows = rowCount(parent);
-    if (rows <= 0 || rows < row + count)
+    if (row < 0 || count <= 0 || rows < row + count)
     {
         return false;
     }
 
-    beginRemoveRows(parent, row, row + count - 1);
-
     RowItem* parentItem = itemFromIndex(parent);
-    for(int i = 0; i < count; i++)
+    if (m_viewActive && parentItem == m_rootItem)
     {
-        parentItem->removeChild(row);
+        //显示位置对应的行不一定连续，从后往前按连续段删除，前面的行号不受影响
+        QVector<int> sources = m_viewRows.mid(row, count);
+        std::sort(sources.begin(), sources.end(), std::greater<int>());
+        for (int i = 0; i < sources.size(); )
+        {
+            int last = sources.at(i);
+            int first = last;
+            while (++i < sources.size() && sources.at(i) == first - 1)
+            {
+                --first;
+            }
+            parentItem->removeChildren(first, last - first + 1);
+        }
+        return true;
     }
 
-    endRemoveRows();
+    parentItem->removeChildren(row, count);
     return true;
 }
 bool RowItemModel::insertColumns(int column, int count, const QModelIndex &parent)
@@ -256,6 +549,20 @@ QStringList RowItemModel::headerKeys() const
 void RowItemModel::setHeaderKeys(const QStringList &headerKeys)
 {
     m_headerKeys = headerKeys;
+
+    //字段名到列的索引，同名字段取第一个，与 indexOf 一致
+    m_headerKeyIndexes.clear();
+    m_headerKeyIndexes.reserve(headerKeys.size());
+    m_headerPropertyNames.clear();
+    m_headerPropertyNames.reserve(headerKeys.size());
+    for (int i = 0; i < headerKeys.size(); i++)
+    {
+        if (!m_headerKeyIndexes.contains(headerKeys.at(i)))
+        {
+            m_headerKeyIndexes.insert(headerKeys.at(i), i);
+        }
+        m_headerPropertyNames.append(headerKeys.at(i).toLocal8Bit());
+    }
 }
 
 QVariantMap RowItemModel::getDataMap(RowItem *item) const
@@ -270,24 +577,36 @@ QVariantMap RowItemModel::getDataMap(RowItem *item) const
 
 void RowItemModel::setRelationMap(int column, const QMap<QString, QVariant> &relationMap)
 {
-    m_relationMaps.insert(column, relationMap);
+    if (column < 0)
+    {
+        return;
+    }
+
+    if (column >= m_relationTables.size())
+    {
+        m_relationTables.resize(column + 1);
+    }
+    m_relationTables[column] = RelationTablePtr(new RelationTable(relationMap));
 }
 
 void RowItemModel::setRelationMap(const QString &columnName, const QMap<QString, QVariant> &relationMap)
 {
-    int index = m_headerKeys.indexOf(columnName);
-    if (index >= 0)
-    {
-        m_relationMaps.insert(index, relationMap);
-    }
+    setRelationMap(headerIndex(columnName), relationMap);
 }
 
 int RowItemModel::headerIndex(const QString &columnName) const
 {
-    return m_headerKeys.indexOf(columnName);
+    return m_headerKeyIndexes.value(columnName, -1);
 }
 
 void RowItemModel::constructTree(const QList<QVariantList> &source, int idIndex, int pidIndex, int rootId)
+{
+    beginBulkLoad();
+    constructTreeItems(source, idIndex, pidIndex, rootId);
+    endBulkLoad();
+}
+
+void RowItemModel::constructTreeItems(const QList<QVariantList> &source, int idIndex, int pidIndex, int rootId)
 {
     int size = source.size();
 
@@ -346,22 +665,1086 @@ void RowItemModel::constructTree(const QList<QVariantList> &source, int idIndex,
     }
 }
 
-QMap<QString, QVariant> RowItemModel::getRelationMap(int column) const
+void RowItemModel::beginBulkLoad()
 {
-    return m_relationMaps.value(column);
+    if (m_bulkLoadDepth++ == 0)
+    {
+        m_pendingChanges.clear();
+        beginResetModel();
+    }
 }
 
-QMap<QString, QVariant> RowItemModel::getRelationMap(const QString &columnName) const
+void RowItemModel::endBulkLoad()
+{
+    if (m_bulkLoadDepth <= 0)
+    {
+        return;
+    }
+
+    if (--m_bulkLoadDepth == 0)
+    {
+        rebuildView();
+        endResetModel();
+    }
+}
+
+bool RowItemModel::isBulkLoading() const
+{
+    return m_bulkLoadDepth > 0;
+}
+
+void RowItemModel::beginInsertItems(RowItem *parent, int first, int last)
+{
+    flushChanges();
+    StructureNotify notify = structureNotify(parent, last - first + 1);
+    m_structureNotifies.append(notify);
+    if (notify == RowsNotify)
+    {
+        beginInsertRows(indexFromItem(parent), first, last);
+    }
+    else if (notify == ViewNotify)
+    {
+        //新行还不在父项中，插入完成后才能算出显示位置
+        m_viewChanges.append(qMakePair(first, last));
+    }
+    else if (notify == ResetNotify)
+    {
+        beginResetModel();
+    }
+}
+
+void RowItemModel::endInsertItems()
+{
+    if (m_structureNotifies.isEmpty())
+    {
+        return;
+    }
+
+    if (m_structureNotifies.last() == RowsNotify)
+    {
+        m_structureNotifies.removeLast();
+        endInsertRows();
+    }
+    else if (m_structureNotifies.last() == ViewNotify)
+    {
+        m_structureNotifies.removeLast();
+        QPair<int, int> range = m_viewChanges.takeLast();
+        insertViewRows(range.first, range.second);
+    }
+    else
+    {
+        endStructureChange();
+    }
+}
+
+void RowItemModel::beginRemoveItems(RowItem *parent, int first, int last)
+{
+    flushChanges();
+    StructureNotify notify = structureNotify(parent, last - first + 1);
+    m_structureNotifies.append(notify);
+    if (notify == RowsNotify)
+    {
+        beginRemoveRows(indexFromItem(parent), first, last);
+    }
+    else if (notify == ViewNotify)
+    {
+        //删除前先从显示中移除，此时各行仍在父项中
+        removeViewRows(first, last);
+        m_viewChanges.append(qMakePair(first, last));
+    }
+    else if (notify == ResetNotify)
+    {
+        beginResetModel();
+    }
+}
+
+void RowItemModel::endRemoveItems()
+{
+    if (m_structureNotifies.isEmpty())
+    {
+        return;
+    }
+
+    if (m_structureNotifies.last() == RowsNotify)
+    {
+        m_structureNotifies.removeLast();
+        endRemoveRows();
+    }
+    else if (m_structureNotifies.last() == ViewNotify)
+    {
+        m_structureNotifies.removeLast();
+        QPair<int, int> range = m_viewChanges.takeLast();
+        shiftViewRows(range.second + 1, range.first - range.second - 1);
+    }
+    else
+    {
+        endStructureChange();
+    }
+}
+
+RowItemModel::StructureNotify RowItemModel::structureNotify(RowItem *parent, int count) const
+{
+    if (m_bulkLoadDepth > 0)
+    {
+        return NoNotify;
+    }
+    if (!m_viewActive)
+    {
+        return RowsNotify;
+    }
+    //排序过滤中顶层行的增删按显示位置逐段通知，行数很多时重建后整体重置
+    if (parent == m_rootItem)
+    {
+        return count > ViewRowsNotifyThreshold ? ResetNotify : ViewNotify;
+    }
+    //隐藏行下面的变化视图看不到
+    return isItemVisible(parent) ? RowsNotify : NoNotify;
+}
+
+void RowItemModel::endStructureChange()
+{
+    StructureNotify notify = m_structureNotifies.takeLast();
+    if (notify == ResetNotify)
+    {
+        rebuildView();
+        endResetModel();
+    }
+}
+
+void RowItemModel::itemDataChanged(RowItem *item)
+{
+    itemColumnsChanged(item, 0, columnCount() - 1);
+}
+
+void RowItemModel::itemColumnsChanged(RowItem *item, int first, int last, int roles)
 {
-    int column = m_headerKeys.indexOf(columnName);
-    return m_relationMaps.value(column);
+    //批量构建中或尚未挂到树上的节点不需要通知
+    if (m_bulkLoadDepth > 0 || item->parent() == Q_NULLPTR)
+    {
+        return;
+    }
+
+    last = qMin(last, columnCount() - 1);
+    if (first < 0 || first > last)
+    {
+        return;
+    }
+
+    //同一节点的多次修改合并成一个列范围，行号到发出时再取
+    auto it = m_pendingChanges.find(item);
+    if (it == m_pendingChanges.end())
+    {
+        m_pendingChanges.insert(item, PendingChange{first, last, roles});
+    }
+    else
+    {
+        it.value().first = qMin(it.value().first, first);
+        it.value().last = qMax(it.value().last, last);
+        it.value().roles |= roles;
+    }
+
+    if (!m_flushScheduled)
+    {
+        m_flushScheduled = true;
+        QTimer::singleShot(0, this, &RowItemModel::flushChanges);
+    }
 }
 
+void RowItemModel::flushChanges()
+{
+    m_flushScheduled = false;
+    if (m_pendingChanges.isEmpty() || m_bulkLoadDepth > 0)
+    {
+        return;
+    }
+
+    QHash<RowItem *, PendingChange> changes;
+    changes.swap(m_pendingChanges);
 
+    //按父节点分组，隐藏的行不发出，顶层行在排序过滤时随后重新判断位置
+    struct DirtyRow
+    {
+        int row;
+        RowItem *item;
+        PendingChange change;
+    };
+    QHash<RowItem *, QVector<DirtyRow>> dirtyRows;
+    QVector<RowItem *> refilterItems;
+    for (auto it = changes.constBegin(); it != changes.constEnd(); ++it)
+    {
+        RowItem *item = it.key();
+        if (item->parent() == Q_NULLPTR)
+        {
+            continue;
+        }
+        if (m_viewActive && item->parent() == m_rootItem)
+        {
+            refilterItems.append(item);
+        }
+        if (isItemVisible(item))
+        {
+            dirtyRows[item->parent()].append(DirtyRow{rowOf(item), item, it.value()});
+        }
+    }
 
+    //同一父节点下行号相邻的合并成一个矩形，列取并集
+    int lastColumn = columnCount() - 1;
+    for (auto it = dirtyRows.begin(); it != dirtyRows.end(); ++it)
+    {
+        QVector<DirtyRow> &rows = it.value();
+        std::sort(rows.begin(), rows.end(), [](const DirtyRow &left, const DirtyRow &right) {
+            return left.row < right.row;
+        });
 
+        int i = 0;
+        while (i < rows.size())
+        {
+            int j = i;
+            PendingChange range = rows.at(i).change;
+            while (j + 1 < rows.size() && rows.at(j + 1).row == rows.at(j).row + 1)
+            {
+                ++j;
+                range.first = qMin(range.first, rows.at(j).change.first);
+                range.last = qMax(range.last, rows.at(j).change.last);
+                range.roles |= rows.at(j).change.roles;
+            }
 
+            QVector<int> roles;
+            if (range.roles & DisplayChange)
+            {
+                roles << Qt::DisplayRole << Qt::EditRole;
+            }
+            if (range.roles & BackgroundChange)
+            {
+                roles << Qt::BackgroundRole;
+            }
+            emit dataChanged(createIndex(rows.at(i).row, range.first, rows.at(i).item),
+                             createIndex(rows.at(j).row, qMin(range.last, lastColumn), rows.at(j).item), roles);
+            i = j + 1;
+        }
+    }
 
+    for (RowItem *item : refilterItems)
+    {
+        refilterItem(item);
+    }
+}
 
+void RowItemModel::setDataSource(const QSharedPointer<RowItemDataSource> &dataSource)
+{
+    beginResetModel();
 
+    m_rootItem->removeChildren();
+    clearFetchStates();
+    m_pendingChanges.clear();
+    m_dataSource = dataSource;
+    rebuildView();
 
+    endResetModel();
+}
+
+QSharedPointer<RowItemDataSource> RowItemModel::dataSource() const
+{
+    return m_dataSource;
+}
+
+void RowItemModel::appendItems(RowItem *parent, const QList<QVariantList> &rows)
+{
+    if (rows.isEmpty())
+    {
+        return;
+    }
+
+    int first = parent->childCount();
+    beginInsertItems(parent, first, first + rows.size() - 1);
+
+    parent->m_children.reserve(first + rows.size());
+    for (const QVariantList &row : rows)
+    {
+        RowItem *item = new RowItem(this);
+        item->setItemData(row);
+        parent->appendChildUnchecked(item);
+    }
+
+    endInsertItems();
+}
+
+void RowItemModel::itemDestroyed(RowItem *item)
+{
+    if (!m_fetchStates.isEmpty())
+    {
+        //已完成但没人等待的预取留着给下一次 fetchMore，不会再收到 finished，需在这里释放
+        auto state = m_fetchStates.find(item);
+        if (state != m_fetchStates.end())
+        {
+            if (state.value().prefetch != Q_NULLPTR)
+            {
+                state.value().prefetch->deleteLater();
+            }
+            m_fetchStates.erase(state);
+        }
+    }
+    if (!m_pendingChanges.isEmpty())
+    {
+        m_pendingChanges.remove(item);
+    }
+}
+
+QMap<QString, QVariant> RowItemModel::getRelationMap(int column) const
+{
+    const RelationTable *table = relationTable(column);
+    return table == Q_NULLPTR ? QMap<QString, QVariant>() : table->map;
+}
+
+QMap<QString, QVariant> RowItemModel::getRelationMap(const QString &columnName) const
+{
+    return getRelationMap(headerIndex(columnName));
+}
+
+const RowItemModel::RelationTable *RowItemModel::relationTable(int column) const
+{
+    if (column < 0 || column >= m_relationTables.size())
+    {
+        return Q_NULLPTR;
+    }
+    return m_relationTables.at(column).data();
+}
+
+RowItemModel::RelationTable::RelationTable(const QMap<QString, QVariant> &relationMap)
+    : map(relationMap)
+{
+    forward.reserve(relationMap.size());
+    reverse.reserve(relationMap.size());
+    for (auto it = relationMap.constBegin(); it != relationMap.constEnd(); ++it)
+    {
+        forward.insert(it.key(), it.value());
+
+        //只收规范写法的整数编码，如 "5"，"05" 转成字符串后不会等于它
+        bool ok = false;
+        qint64 number = it.key().toLongLong(&ok);
+        if (ok && QString::number(number) == it.key())
+        {
+            forwardByInt.insert(number, it.value());
+        }
+
+        //QMap 按编码升序遍历，先插入的即为 QMap::key 返回的编码
+        QString text = it.value().toString();
+        if (!reverse.contains(text))
+        {
+            reverse.insert(text, it.key());
+        }
+    }
+}
+
+QVariant RowItemModel::RelationTable::translate(const QVariant &code) const
+{
+    switch (code.userType())
+    {
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::Short:
+    case QMetaType::UShort:
+    case QMetaType::LongLong:
+        return forwardByInt.value(code.toLongLong());
+    default:
+        //QString 类型的 toString 只是共享拷贝，不会分配内存
+        return forward.value(code.toString());
+    }
+}
+
+QString RowItemModel::RelationTable::code(const QVariant &value) const
+{
+    return reverse.value(value.toString());
+}
+
+
+
+
+
+
+
+
+
+
+void RowItemModel::sort(int column, Qt::SortOrder order)
+{
+    if (column < 0)
+    {
+        sortBy(QVector<SortColumn>());
+        return;
+    }
+
+    sortBy(QVector<SortColumn>({SortColumn{column, order}}));
+}
+
+void RowItemModel::sortBy(const QVector<SortColumn> &columns)
+{
+    m_sortColumns.clear();
+    for (const SortColumn &sortColumn : columns)
+    {
+        if (sortColumn.column >= 0 && sortColumn.column < columnCount())
+        {
+            m_sortColumns.append(sortColumn);
+        }
+    }
+
+    applyView();
+}
+
+QVector<RowItemModel::SortColumn> RowItemModel::sortColumns() const
+{
+    return m_sortColumns;
+}
+
+void RowItemModel::setFilter(const std::function<bool (const RowItem *)> &filter)
+{
+    m_filter = filter;
+    applyView();
+}
+
+void RowItemModel::invalidateView()
+{
+    applyView();
+}
+
+void RowItemModel::refilterItem(RowItem *item)
+{
+    //结构变化进行中时由变化结束后的重建处理
+    if (!m_viewActive || item == Q_NULLPTR || item->parent() != m_rootItem
+            || m_bulkLoadDepth > 0 || !m_structureNotifies.isEmpty())
+    {
+        return;
+    }
+
+    int source = item->row();
+    int from = m_sourceToView.value(source, -1);
+    bool accepted = !m_filter || m_filter(item);
+
+    if (!accepted)
+    {
+        if (from >= 0)
+        {
+            beginRemoveRows(QModelIndex(), from, from);
+            m_viewRows.remove(from);
+            m_sourceToView[source] = -1;
+            updateSourceToView(from);
+            endRemoveRows();
+        }
+        return;
+    }
+
+    int to = viewPosition(source, from);
+    if (from < 0)
+    {
+        beginInsertRows(QModelIndex(), to, to);
+        m_viewRows.insert(to, source);
+        updateSourceToView(to);
+        endInsertRows();
+    }
+    else if (to != from)
+    {
+        //to 是去掉自身后的位置，beginMoveRows 需要的是移动前的目标位置
+        beginMoveRows(QModelIndex(), from, from, QModelIndex(), to > from ? to + 1 : to);
+        m_viewRows.remove(from);
+        m_viewRows.insert(to, source);
+        updateSourceToView(qMin(from, to));
+        endMoveRows();
+    }
+}
+
+RowItem *RowItemModel::childAt(RowItem *parent, int row) const
+{
+    if (m_viewActive && parent == m_rootItem)
+    {
+        if (row < 0 || row >= m_viewRows.size())
+        {
+            return Q_NULLPTR;
+        }
+        return parent->child(m_viewRows.at(row));
+    }
+    return parent->child(row);
+}
+
+int RowItemModel::rowOf(const RowItem *item) const
+{
+    if (m_viewActive && item->parent() == m_rootItem)
+    {
+        return m_sourceToView.value(item->row(), -1);
+    }
+    return item->row();
+}
+
+bool RowItemModel::isItemVisible(const RowItem *item) const
+{
+    if (!m_viewActive || item == m_rootItem)
+    {
+        return true;
+    }
+
+    //只有顶层行会被过滤，找到所在的顶层行
+    while (item != Q_NULLPTR && item->parent() != m_rootItem)
+    {
+        item = item->parent();
+    }
+    return item != Q_NULLPTR && m_sourceToView.value(item->row(), -1) >= 0;
+}
+
+void RowItemModel::rebuildView()
+{
+    m_viewActive = !m_sortColumns.isEmpty() || m_filter;
+    m_viewRows.clear();
+    m_sourceToView.clear();
+    if (!m_viewActive)
+    {
+        return;
+    }
+
+    int count = m_rootItem->childCount();
+    m_viewRows.reserve(count);
+    for (int i = 0; i < count; i++)
+    {
+        if (!m_filter || m_filter(m_rootItem->child(i)))
+        {
+            m_viewRows.append(i);
+        }
+    }
+
+    sortRows(m_viewRows);
+
+    m_sourceToView.fill(-1, count);
+    updateSourceToView();
+}
+
+void RowItemModel::applyView()
+{
+    applyLayout(nullptr);
+}
+
+void RowItemModel::applyLayout(const std::function<void()> &change)
+{
+    flushChanges();
+    if (m_bulkLoadDepth > 0)
+    {
+        //批量构建结束时统一重建
+        if (change)
+        {
+            change();
+        }
+        return;
+    }
+
+    emit layoutAboutToBeChanged();
+
+    //记下持久索引对应的项，重建后按新的位置更新，被过滤掉的置为无效
+    const QModelIndexList oldIndexes = persistentIndexList();
+    QVector<RowItem *> items;
+    items.reserve(oldIndexes.size());
+    for (const QModelIndex &index : oldIndexes)
+    {
+        items.append(itemFromIndex(index));
+    }
+
+    if (change)
+    {
+        change();
+    }
+    rebuildView();
+
+    QModelIndexList newIndexes;
+    newIndexes.reserve(oldIndexes.size());
+    for (int i = 0; i < oldIndexes.size(); i++)
+    {
+        RowItem *item = items.at(i);
+        if (isItemVisible(item))
+        {
+            newIndexes.append(createIndex(rowOf(item), oldIndexes.at(i).column(), item));
+        }
+        else
+        {
+            newIndexes.append(QModelIndex());
+        }
+    }
+    changePersistentIndexList(oldIndexes, newIndexes);
+
+    emit layoutChanged();
+}
+
+void RowItemModel::updateSourceToView(int from)
+{
+    for (int i = from; i < m_viewRows.size(); i++)
+    {
+        m_sourceToView[m_viewRows.at(i)] = i;
+    }
+}
+
+void RowItemModel::shiftViewRows(int from, int count)
+{
+    for (int &source : m_viewRows)
+    {
+        if (source >= from)
+        {
+            source += count;
+        }
+    }
+
+    if (count > 0)
+    {
+        m_sourceToView.insert(from, count, -1);
+    }
+    else
+    {
+        m_sourceToView.remove(from + count, -count);
+    }
+}
+
+void RowItemModel::insertViewRows(int first, int last)
+{
+    shiftViewRows(first, last - first + 1);
+
+    //insertRows 指定了位置时新行整体显示在该处
+    if (m_insertViewRow >= 0)
+    {
+        int to = qMin(m_insertViewRow, m_viewRows.size());
+        beginInsertRows(QModelIndex(), to, to + last - first);
+        for (int source = last; source >= first; source--)
+        {
+            m_viewRows.insert(to, source);
+        }
+        updateSourceToView(to);
+        endInsertRows();
+        return;
+    }
+
+    QVector<int> sources;
+    sources.reserve(last - first + 1);
+    for (int source = first; source <= last; source++)
+    {
+        if (!m_filter || m_filter(m_rootItem->child(source)))
+        {
+            sources.append(source);
+        }
+    }
+    if (sources.isEmpty())
+    {
+        return;
+    }
+    sortRows(sources);
+
+    //新行已排好序，落在同一位置的连成一段。从后往前插入，前面各段的位置不受影响
+    QVector<int> positions;
+    positions.reserve(sources.size());
+    for (int source : sources)
+    {
+        positions.append(viewPosition(source, -1));
+    }
+    for (int end = sources.size(); end > 0; )
+    {
+        int begin = end - 1;
+        while (begin > 0 && positions.at(begin - 1) == positions.at(end - 1))
+        {
+            --begin;
+        }
+
+        int to = positions.at(begin);
+        beginInsertRows(QModelIndex(), to, to + end - begin - 1);
+        m_viewRows.insert(to, end - begin, 0);
+        std::copy(sources.constBegin() + begin, sources.constBegin() + end, m_viewRows.begin() + to);
+        updateSourceToView(to);
+        endInsertRows();
+        end = begin;
+    }
+}
+
+void RowItemModel::removeViewRows(int first, int last)
+{
+    QVector<int> positions;
+    for (int source = first; source <= last; source++)
+    {
+        int position = m_sourceToView.value(source, -1);
+        if (position >= 0)
+        {
+            positions.append(position);
+        }
+    }
+    std::sort(positions.begin(), positions.end(), std::greater<int>());
+
+    //从后往前按连续的显示位置分段移除，前面各段的位置不受影响
+    for (int i = 0; i < positions.size(); )
+    {
+        int to = positions.at(i);
+        int from = to;
+        while (++i < positions.size() && positions.at(i) == from - 1)
+        {
+            --from;
+        }
+
+        beginRemoveRows(QModelIndex(), from, to);
+        for (int position = from; position <= to; position++)
+        {
+            m_sourceToView[m_viewRows.at(position)] = -1;
+        }
+        m_viewRows.remove(from, to - from + 1);
+        updateSourceToView(from);
+        endRemoveRows();
+    }
+}
+
+QVariant RowItemModel::sortData(const RowItem *item, int column) const
+{
+    QVariant value = item->data(column);
+    const RelationTable *table = relationTable(column);
+    return table == Q_NULLPTR ? value : table->translate(value);
+}
+
+void RowItemModel::sortRows(QVector<int> &rows) const
+{
+    const int columnCount = m_sortColumns.size();
+    const int count = rows.size();
+    if (columnCount == 0 || count < 2)
+    {
+        return;
+    }
+
+    int *data = rows.data();
+
+    //先取出每行的排序键，比较时不再访问 RowItem 和关系映射
+    QVector<SortKey> keys(m_rootItem->childCount() * columnCount);
+    SortKey *keyData = keys.data();
+    auto fillKeys = [this, data, keyData, columnCount](const QPair<int, int> &range) {
+        for (int i = range.first; i < range.second; i++)
+        {
+            const RowItem *item = m_rootItem->child(data[i]);
+            SortKey *rowKeys = keyData + data[i] * columnCount;
+            for (int c = 0; c < columnCount; c++)
+            {
+                rowKeys[c] = makeSortKey(sortData(item, m_sortColumns.at(c).column));
+            }
+        }
+    };
+
+    auto lessThan = [this, keyData, columnCount](int left, int right) {
+        const SortKey *leftKeys = keyData + left * columnCount;
+        const SortKey *rightKeys = keyData + right * columnCount;
+        for (int c = 0; c < columnCount; c++)
+        {
+            int result = compareSortKey(leftKeys[c], rightKeys[c]);
+            if (result != 0)
+            {
+                return m_sortColumns.at(c).order == Qt::AscendingOrder ? result < 0 : result > 0;
+            }
+        }
+        //相同时保持原来的先后
+        return left < right;
+    };
+
+    int threads = QThread::idealThreadCount();
+    if (count < ParallelSortThreshold || threads <= 1)
+    {
+        fillKeys(qMakePair(0, count));
+        std::sort(data, data + count, lessThan);
+        return;
+    }
+
+    //分段并行取键和排序，再逐轮两两并行归并
+    QVector<QPair<int, int>> ranges = splitRanges(count, threads);
+    QtConcurrent::blockingMap(ranges, fillKeys);
+    QtConcurrent::blockingMap(ranges, [data, &lessThan](const QPair<int, int> &range) {
+        std::sort(data + range.first, data + range.second, lessThan);
+    });
+
+    struct MergeRange
+    {
+        int first;
+        int middle;
+        int last;
+    };
+    while (ranges.size() > 1)
+    {
+        QVector<MergeRange> merges;
+        QVector<QPair<int, int>> merged;
+        for (int i = 0; i + 1 < ranges.size(); i += 2)
+        {
+            merges.append(MergeRange{ranges.at(i).first, ranges.at(i).second, ranges.at(i + 1).second});
+            merged.append(qMakePair(ranges.at(i).first, ranges.at(i + 1).second));
+        }
+        if (ranges.size() % 2 != 0)
+        {
+            merged.append(ranges.last());
+        }
+
+        QtConcurrent::blockingMap(merges, [data, &lessThan](const MergeRange &range) {
+            std::inplace_merge(data + range.first, data + range.middle, data + range.last, lessThan);
+        });
+        ranges = merged;
+    }
+}
+
+int RowItemModel::viewPosition(int source, int skip) const
+{
+    const RowItem *item = m_rootItem->child(source);
+    const int columnCount = m_sortColumns.size();
+    QVector<SortKey> keys;
+    keys.reserve(columnCount);
+    for (int c = 0; c < columnCount; c++)
+    {
+        keys.append(makeSortKey(sortData(item, m_sortColumns.at(c).column)));
+    }
+
+    //other 是否排在 source 之前，与 sortRows 的比较规则一致；未排序时按行号
+    auto precedes = [&](int other) {
+        const RowItem *otherItem = m_rootItem->child(other);
+        for (int c = 0; c < columnCount; c++)
+        {
+            int result = compareSortKey(makeSortKey(sortData(otherItem, m_sortColumns.at(c).column)), keys.at(c));
+            if (result != 0)
+            {
+                return m_sortColumns.at(c).order == Qt::AscendingOrder ? result < 0 : result > 0;
+            }
+        }
+        return other < source;
+    };
+
+    int low = 0;
+    int high = m_viewRows.size() - (skip >= 0 ? 1 : 0);
+    while (low < high)
+    {
+        int mid = (low + high) / 2;
+        int other = m_viewRows.at(skip >= 0 && mid >= skip ? mid + 1 : mid);
+        if (precedes(other))
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+void RowItemModel::applySnapshot(const QList<QVariantList> &rows, const QString &keyName)
+{
+    applySnapshot(rows, headerIndex(keyName));
+}
+
+void RowItemModel::applySnapshot(const QList<QVariantList> &rows, int keyColumn)
+{
+    if (keyColumn < 0)
+    {
+        return;
+    }
+    flushChanges();
+
+    //新数据按键建立索引，重复的键只取第一行
+    QHash<QString, int> newRowOfKey;
+    newRowOfKey.reserve(rows.size());
+    for (int i = 0; i < rows.size(); i++)
+    {
+        QString key = rows.at(i).value(keyColumn).toString();
+        if (!newRowOfKey.contains(key))
+        {
+            newRowOfKey.insert(key, i);
+        }
+    }
+
+    //旧行按键匹配新行
+    QVector<RowItem *> matched(rows.size(), Q_NULLPTR);
+    int oldCount = m_rootItem->childCount();
+    QVector<bool> keep(oldCount, false);
+    for (int i = 0; i < oldCount; i++)
+    {
+        RowItem *item = m_rootItem->child(i);
+        int newRow = newRowOfKey.value(item->value(keyColumn).toString(), -1);
+        if (newRow >= 0 && matched.at(newRow) == Q_NULLPTR)
+        {
+            matched[newRow] = item;
+            keep[i] = true;
+        }
+    }
+
+    //增删的段数太多时逐段通知的代价超过重置，一次性换成新的子项列表
+    int runs = 0;
+    for (int i = 0; i < oldCount; i++)
+    {
+        if (!keep.at(i) && (i == 0 || keep.at(i - 1)))
+        {
+            ++runs;
+        }
+    }
+    for (int i = 0; i < rows.size(); i++)
+    {
+        if (matched.at(i) == Q_NULLPTR && (i == 0 || matched.at(i - 1) != Q_NULLPTR))
+        {
+            ++runs;
+        }
+    }
+    const bool reset = runs > SnapshotRunsThreshold;
+    if (reset)
+    {
+        beginBulkLoad();
+        QList<RowItem *> removed;
+        for (int i = 0; i < oldCount; i++)
+        {
+            if (!keep.at(i))
+            {
+                removed.append(m_rootItem->child(i));
+            }
+        }
+        m_rootItem->m_children.clear();
+        m_rootItem->invalidateRows();
+        for (int i = 0; i < rows.size(); i++)
+        {
+            RowItem *item = matched.at(i);
+            if (item == Q_NULLPTR)
+            {
+                item = new RowItem(this);
+                item->setItemData(rows.at(i));
+            }
+            m_rootItem->appendChildUnchecked(item);
+        }
+        for (RowItem *item : removed)
+        {
+            item->m_parent = Q_NULLPTR;
+            delete item;
+        }
+    }
+    else
+    {
+        //匹配不上的旧行从后往前按连续段删除，前面的行号不受影响
+        for (int last = oldCount - 1; last >= 0; )
+        {
+            if (keep.at(last))
+            {
+                --last;
+                continue;
+            }
+
+            int first = last;
+            while (first > 0 && !keep.at(first - 1))
+            {
+                --first;
+            }
+            m_rootItem->removeChildren(first, last - first + 1);
+            last = first - 1;
+        }
+
+        //保留的行按新顺序一次排好，只发出一次布局变化，行号在下一次查询时统一重新编号
+        QList<RowItem *> order;
+        order.reserve(m_rootItem->childCount());
+        for (RowItem *item : matched)
+        {
+            if (item != Q_NULLPTR)
+            {
+                order.append(item);
+            }
+        }
+        if (order != m_rootItem->m_children)
+        {
+            applyLayout([this, &order]() {
+                m_rootItem->m_children.swap(order);
+                m_rootItem->invalidateRows();
+            });
+        }
+
+        //新行按连续段从前往后插在最终位置，前面的行都已就位
+        for (int i = 0; i < rows.size(); )
+        {
+            if (matched.at(i) != Q_NULLPTR)
+            {
+                ++i;
+                continue;
+            }
+
+            int first = i;
+            QList<RowItem *> items;
+            for (; i < rows.size() && matched.at(i) == Q_NULLPTR; i++)
+            {
+                RowItem *newItem = new RowItem(this);
+                newItem->setItemData(rows.at(i));
+                items.append(newItem);
+            }
+            m_rootItem->insertChildren(first, items);
+        }
+    }
+
+    //保留的行只更新并通知变化了的列
+    for (int i = 0; i < rows.size(); i++)
+    {
+        RowItem *item = matched.at(i);
+        if (item == Q_NULLPTR)
+        {
+            continue;
+        }
+
+        const QVariantList &row = rows.at(i);
+        int first = -1;
+        int last = -1;
+        if (item->m_data.size() != row.size())
+        {
+            first = 0;
+            last = qMax(item->m_data.size(), row.size()) - 1;
+            item->m_data.resize(row.size());
+        }
+        for (int column = 0; column < row.size(); column++)
+        {
+            if (item->m_data.at(column) != row.at(column))
+            {
+                item->m_data[column] = row.at(column);
+                if (first < 0)
+                {
+                    first = column;
+                }
+                last = qMax(last, column);
+            }
+        }
+
+        if (first >= 0)
+        {
+            itemColumnsChanged(item, first, last);
+        }
+    }
+
+    if (reset)
+    {
+        endBulkLoad();
+    }
+}
+
+void RowItemModel::attachItems(const QList<RowItem *> &items, RowItem *parent)
+{
+    if (parent == Q_NULLPTR)
+    {
+        parent = m_rootItem;
+    }
+
+    QList<RowItem *> validItems;
+    validItems.reserve(items.size());
+    for (RowItem *item : items)
+    {
+        //已挂在其他节点下的不能再挂
+        if (item != Q_NULLPTR && item->parent() == Q_NULLPTR)
+        {
+            item->setModel(this);
+            validItems.append(item);
+        }
+    }
+
+    parent->insertChildren(parent->childCount(), validItems);
+}
+
+QFuture<void> RowItemModel::populateAsync(const std::function<void (RowItemBuilder &)> &build)
+{
+    //构建器由任务和完成回调共同持有，模型先析构时未挂上的节点随构建器释放
+    QSharedPointer<RowItemBuilder> builder(new RowItemBuilder(m_headerKeys));
+    QFuture<void> future = QtConcurrent::run([builder, build]() {
+        build(*builder);
+    });
+
+    QFutureWatcher<void> *watcher = new QFutureWatcher<void>(this);
+    connect(watcher, &QFutureWatcher<void>::finished, this, [this, watcher, builder]() {
+        attachItems(builder->takeItems());
+        watcher->deleteLater();
+    });
+    watcher->setFuture(future);
+    return future;
+}
@@ -15,9 +15,15 @@
 #define RPWITEMMODEL_H
 
 #include <QAbstractItemModel>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QSharedPointer>
+#include <functional>
 #include "../mvvm_global.h"
 
 class RowItem;
+class RowItemBuilder;
+class RowItemDataSource;
 
 class MVVM_EXPORT RowItemModel : public QAbstractItemModel
 {
@@ -124,6 +130,30 @@ public:
 
 
 
+    /******************************************************************************
+     *
+     *                            按需加载需实现
+     *
+     *****************************************************************************/
+    /**
+     * @brief 父节点是否有子项。设置了数据源时，未加载的节点由数据源判断
+     */
+    bool hasChildren(const QModelIndex &parent = QModelIndex()) const override;
+
+    /**
+     * @brief 父节点下是否还有未加载的数据
+     */
+    bool canFetchMore(const QModelIndex &parent) const override;
+
+    /**
+     * @brief 加载父节点下的下一页数据，并在后台预取再下一页。
+     *        预取尚未完成时不等待，预取完成后自动插入该页
+     */
+    void fetchMore(const QModelIndex &parent) override;
+
+
+
+
     /******************************************************************************
      *
      *                            以下部分为扩展功能
@@ -196,7 +226,8 @@ public:
 
 
     /**
-     * @brief 返回给定表头字段在表头对应的位置
+     * @brief 返回给定表头字段在表头对应的位置，不存在时返回 -1。按哈希查找，
+     *        频繁访问时也可先取得列索引再使用 RowItem::value(int)
      */
     int headerIndex(const QString &columnName) const;
 
@@ -206,12 +237,290 @@ public:
      */
     void constructTree(const QList<QVariantList> &source, int idIndex, int pidIndex, int rootId = -1);
 
+    /**
+     * @brief 开始批量构建，期间添加子项不做重复检查，也不发出逐项的增删和数据变化信号，
+     *        由最外层的 endBulkLoad 统一重置模型。可嵌套调用
+     */
+    void beginBulkLoad();
+
+    /**
+     * @brief 结束批量构建，最外层结束时通知视图重置
+     */
+    void endBulkLoad();
+
+    /**
+     * @brief 是否处于批量构建中
+     */
+    bool isBulkLoading() const;
+
+    /**
+     * @brief 设置分页数据源，模型被清空，之后数据由视图通过 fetchMore 按需加载。传入空指针则关闭按需加载
+     */
+    void setDataSource(const QSharedPointer<RowItemDataSource> &dataSource);
+
+    /**
+     * @brief 返回分页数据源
+     */
+    QSharedPointer<RowItemDataSource> dataSource() const;
+
+    /**
+     * @brief 排序条件中的一列
+     */
+    struct SortColumn
+    {
+        int column;
+        Qt::SortOrder order;
+    };
+
+    /**
+     * @brief 按单列排序，column 小于 0 时取消排序
+     */
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+    /**
+     * @brief 按多列排序，靠前的列优先。只排顶层行，RowItem 本身不移动，模型另外维护显示顺序；
+     *        按显示值比较（经过关系映射），数值和日期按数值比较，其余按字符串比较，
+     *        行数较多时分段并行排序后归并。传入空列表取消排序
+     */
+    void sortBy(const QVector<SortColumn> &columns);
+
+    /**
+     * @brief 返回当前的排序条件
+     */
+    QVector<SortColumn> sortColumns() const;
+
+    /**
+     * @brief 设置顶层行的过滤条件，返回 false 的行不显示。传入空函数取消过滤
+     */
+    void setFilter(const std::function<bool(const RowItem *item)> &filter);
+
+    /**
+     * @brief 重新判断某个顶层行是否通过过滤以及排序后的位置，只发出这一行的增删或移动信号。
+     *        通过 RowItem 或模型修改数据时会自动调用
+     */
+    void refilterItem(RowItem *item);
+
+    /**
+     * @brief 重新过滤和排序全部顶层行，过滤条件依赖的外部状态变化后调用
+     */
+    void invalidateView();
+
+    /**
+     * @brief 用新的数据集刷新顶层行，按 keyColumn 列的值与现有行匹配：匹配不上的旧行删除，
+     *        新出现的行插入，位置变化的行移动，只对变化了的列发出 dataChanged。
+     *        删除和插入按连续段通知，行的移动合并为一次布局变化，整体为 O(n)。
+     *        不重置模型，视图的滚动、选择和展开状态得以保留，已有行的子项保持不变；
+     *        增删的段数过多时改为重置。重复的键只匹配第一行
+     */
+    void applySnapshot(const QList<QVariantList> &rows, int keyColumn);
+
+    /**
+     * @brief 同上，按表头字段指定键列
+     */
+    void applySnapshot(const QList<QVariantList> &rows, const QString &keyName);
+
+    /**
+     * @brief 立即发出累积的数据变化。通过 RowItem 修改数据和设置背景色时不逐次发出 dataChanged，
+     *        先按节点记下变化的列，在事件循环的下一轮或调用本函数时，把同一父节点下相邻的行合并成尽量少的矩形区域发出
+     */
+    void flushChanges();
+
+    /**
+     * @brief 把在模型外构建的节点（见 RowItemBuilder）关联到本模型，追加到 parent 下，只发出一次插入信号。
+     *        parent 为空时追加到根节点下。需在模型所在线程调用
+     */
+    void attachItems(const QList<RowItem *> &items, RowItem *parent = nullptr);
+
+    /**
+     * @brief 在工作线程中调用 build 构建节点，完成后回到模型所在线程追加到根节点下。
+     *        build 中只能使用传入的 builder，不能访问模型。返回构建任务的 future
+     */
+    QFuture<void> populateAsync(const std::function<void(RowItemBuilder &builder)> &build);
+
 protected:
     QStringList m_headers; //表头
     QStringList m_headerKeys; //表头字段
-    QHash<int, QMap<QString, QVariant>> m_relationMaps; //关系映射集合
+    QHash<QString, int> m_headerKeyIndexes; //表头字段--列索引
+    QList<QByteArray> m_headerPropertyNames; //表头字段对应的属性名，供从对象取值使用
+
+    /**
+     * @brief 某一列的关系映射，构造后只读，在模型间共享。正反向都预先建好哈希表，
+     *        整数编码另建整数键的表，显示时不必把原始值转成字符串
+     */
+    struct RelationTable
+    {
+        explicit RelationTable(const QMap<QString, QVariant> &relationMap);
+
+        //编码翻译成显示值
+        QVariant translate(const QVariant &code) const;
+        //显示值翻译回编码，按字符串比较，多个编码对应同一显示值时与 QMap::key 一样取最小的编码
+        QString code(const QVariant &value) const;
+
+        QMap<QString, QVariant> map; //原始映射
+        QHash<QString, QVariant> forward; //编码--显示值
+        QHash<qint64, QVariant> forwardByInt; //整数编码--显示值
+        QHash<QString, QString> reverse; //显示值--编码
+    };
+    typedef QSharedPointer<const RelationTable> RelationTablePtr;
+
+    /**
+     * @brief 返回某一列的关系映射表，没有时返回空指针
+     */
+    const RelationTable *relationTable(int column) const;
+
+    QVector<RelationTablePtr> m_relationTables; //列--关系映射表
     RowItem* m_rootItem; //根项
 
+private:
+    /**
+     * @brief RowItem 增删子项和修改数据时的通知入口，批量构建中不发出信号
+     */
+    void beginInsertItems(RowItem *parent, int first, int last);
+    void endInsertItems();
+    void beginRemoveItems(RowItem *parent, int first, int last);
+    void endRemoveItems();
+    void itemDataChanged(RowItem *item);
+    //数据变化涉及的角色
+    enum ChangeRole
+    {
+        DisplayChange = 0x1,
+        BackgroundChange = 0x2
+    };
+    void itemColumnsChanged(RowItem *item, int first, int last, int roles = DisplayChange);
+
+    //结构变化的通知方式：不通知、按行通知、排序过滤中的顶层行按显示位置通知、重置模型
+    enum StructureNotify
+    {
+        NoNotify,
+        RowsNotify,
+        ViewNotify,
+        ResetNotify
+    };
+    StructureNotify structureNotify(RowItem *parent, int count = 1) const;
+    void endStructureChange();
+
+    /**
+     * @brief 排序过滤时顶层行的显示位置与 RowItem 行号之间的转换，未排序过滤时两者相同
+     */
+    RowItem *childAt(RowItem *parent, int row) const;
+    int rowOf(const RowItem *item) const;
+
+    /**
+     * @brief 节点所在的顶层行是否显示
+     */
+    bool isItemVisible(const RowItem *item) const;
+
+    /**
+     * @brief 按当前的过滤和排序条件重建显示顺序，不发出信号
+     */
+    void rebuildView();
+
+    /**
+     * @brief 重建显示顺序，并以布局变化通知视图，同时更新持久索引
+     */
+    void applyView();
+
+    /**
+     * @brief 在一次布局变化中执行 change（只能调整行的先后，不能增删行），之后重建显示顺序并更新持久索引。
+     *        批量构建中只执行 change
+     */
+    void applyLayout(const std::function<void()> &change);
+
+    /**
+     * @brief 顶层行 source 按排序条件在其余显示行中应处的位置，skip 为其自身当前的显示位置，不在显示中时为 -1
+     */
+    int viewPosition(int source, int skip) const;
+
+    /**
+     * @brief 对顶层行号排序
+     */
+    void sortRows(QVector<int> &rows) const;
+
+    /**
+     * @brief 返回参与排序的显示值
+     */
+    QVariant sortData(const RowItem *item, int column) const;
+
+    /**
+     * @brief 从 from 开始重新计算 RowItem 行号到显示位置的映射
+     */
+    void updateSourceToView(int from = 0);
+
+    /**
+     * @brief 顶层行从 from 开始的行号整体移动 count（负数为前移），显示顺序不变
+     */
+    void shiftViewRows(int from, int count);
+
+    /**
+     * @brief 顶层新增的 first 到 last 行按排序过滤放入显示，落在同一位置的一段发出一次插入信号
+     */
+    void insertViewRows(int first, int last);
+
+    /**
+     * @brief 顶层即将删除的 first 到 last 行从显示中移除，连续的一段发出一次删除信号
+     */
+    void removeViewRows(int first, int last);
+
+    void constructTreeItems(const QList<QVariantList> &source, int idIndex, int pidIndex, int rootId);
+
+    /**
+     * @brief 在父节点末尾追加多行数据，只发出一次插入信号
+     */
+    void appendItems(RowItem *parent, const QList<QVariantList> &rows);
+
+    /**
+     * @brief 加载节点下的下一页数据，预取尚未完成时只记下请求
+     */
+    void fetchItem(RowItem *item);
+
+    /**
+     * @brief 预取完成，视图在等待这一页时插入
+     */
+    void prefetchFinished(RowItem *item, QFutureWatcher<QList<QVariantList>> *watcher);
+
+    /**
+     * @brief 丢弃所有按需加载状态，并释放其中的预取
+     */
+    void clearFetchStates();
+
+    /**
+     * @brief 节点析构时清理其按需加载的状态
+     */
+    void itemDestroyed(RowItem *item);
+
+    //某个父节点的按需加载状态
+    struct FetchState
+    {
+        int fetched = 0; //已加载的行数
+        bool finished = false; //是否已全部加载
+        bool waiting = false; //视图已请求下一页，预取完成后立即插入
+        QFutureWatcher<QList<QVariantList>> *prefetch = Q_NULLPTR; //后台预取的下一页，没有预取时为空
+    };
+
+    QSharedPointer<RowItemDataSource> m_dataSource; //分页数据源
+    QHash<RowItem *, FetchState> m_fetchStates; //父节点--按需加载状态
+
+    int m_bulkLoadDepth = 0; //批量构建嵌套层数
+
+    //某个节点待发出的数据变化
+    struct PendingChange
+    {
+        int first; //起始列
+        int last; //结束列
+        int roles; //ChangeRole 的组合
+    };
+    QHash<RowItem *, PendingChange> m_pendingChanges; //节点--待发出的数据变化
+    bool m_flushScheduled = false; //是否已安排在下一轮事件循环发出
+    QVector<StructureNotify> m_structureNotifies; //进行中的结构变化各自采用的通知方式
+
+    QVector<SortColumn> m_sortColumns; //排序条件
+    std::function<bool(const RowItem *item)> m_filter; //过滤条件
+    bool m_viewActive = false; //是否有排序或过滤
+    QVector<int> m_viewRows; //显示位置--顶层 RowItem 行号
+    QVector<int> m_sourceToView; //顶层 RowItem 行号--显示位置，过滤掉的为 -1
+    QVector<QPair<int, int>> m_viewChanges; //进行中的顶层行增删的行号范围
+    int m_insertViewRow = -1; //insertRows 指定的显示位置，新行显示在此处而不按排序过滤放置
+
     friend class RowItem;
 };
 
@@ -3,8 +3,11 @@ DEFINES += MVVM_LIBRARY
 SOURCES += \
     $$PWD/connector/connectorcontainer.cpp \
     $$PWD/models/rowitem.cpp \
+    $$PWD/models/rowitembuilder.cpp \
+    $$PWD/models/rowitemdatasource.cpp \
     $$PWD/models/rowitemmodel.cpp \
     $$PWD/navigators/mvvmviewcontainer.cpp \
+    $$PWD/navigators/navigationtrace.cpp \
     $$PWD/navigators/navigator.cpp \
     $$PWD/navigators/navigatorsetting.cpp \
     $$PWD/properties/propertybase.cpp \
@@ -17,10 +20,13 @@ HEADERS += \
     $$PWD/connector/connector.h \
     $$PWD/connector/connectorcontainer.h \
     $$PWD/models/rowitem.h \
+    $$PWD/models/rowitembuilder.h \
+    $$PWD/models/rowitemdatasource.h \
     $$PWD/models/rowitemmodel.h \
     $$PWD/mvvm_global.h \
     $$PWD/mvvms.h \
     $$PWD/navigators/mvvmviewcontainer.h \
+    $$PWD/navigators/navigationtrace.h \
     $$PWD/navigators/navigator.h \
     $$PWD/navigators/navigatorsetting.h \
     $$PWD/properties/propertybase.h \
@@ -1,5 +1,43 @@
 #include "mvvmviewcontainer.h"
 
+#include <QDateTime>
+#include <QEvent>
+#include <QPointer>
+#include <QTimer>
+#include <QWidget>
+
+namespace {
+const char FirstPaintWatcherName[] = "_mvvm_firstPaintWatcher";
+
+//监视 view 的首次绘制，之后自行删除
+class FirstPaintWatcher : public QObject
+{
+public:
+    FirstPaintWatcher(QObject *view, std::function<void()> callback)
+        : QObject(view), _callback(callback)
+    {
+        setObjectName(QLatin1String(FirstPaintWatcherName));
+        view->installEventFilter(this);
+    }
+
+    bool eventFilter(QObject *watched, QEvent *event) override
+    {
+        if (event->type() == QEvent::Paint && _callback != nullptr)
+        {
+            watched->removeEventFilter(this);
+            auto callback = _callback;
+            _callback = nullptr;
+            callback();
+            deleteLater();
+        }
+        return false;
+    }
+
+private:
+    std::function<void()> _callback;
+};
+}
+
 Mvvms::IMvvmViewPair::IMvvmViewPair(QObject *parent)
     :   IDIObj(parent)
 {
@@ -9,12 +47,18 @@ Mvvms::IMvvmViewPair::IMvvmViewPair(QObject *parent)
 Mvvms::IMvvmViewPair::~IMvvmViewPair()
 {
     createView = nullptr;
+    placeViewFunc = nullptr;
     qDeleteAll(_viewObjects);
 }
 
 QObject *Mvvms::IMvvmViewPair::getView()
 {
-    return _viewObjects.count() > 0 ? _viewObjects.at(0) : nullptr;
+    for (QObject *view : _viewObjects)
+    {
+        if (!_idleViews.contains(view))
+            return view;
+    }
+    return nullptr;
 }
 
 QObject *Mvvms::IMvvmViewPair::newView(INavigatorSetting *setting)
@@ -32,6 +76,25 @@ QObject *Mvvms::IMvvmViewPair::newView(INavigatorSetting *setting)
     return nullptr;
 }
 
+void Mvvms::IMvvmViewPair::placeView(QObject *view, INavigatorSetting *setting, bool recycled)
+{
+    if (placeViewFunc != nullptr)
+    {
+        placeViewFunc(view, setting);
+        return;
+    }
+
+    //新建的 view 由 createView 放置，复用的 view 放回导航设置指定的父窗口并显示
+    if (!recycled)
+        return;
+
+    if (auto widget = qobject_cast<QWidget *>(view))
+    {
+        widget->setParent(setting != nullptr ? setting->parent : nullptr, widget->windowFlags());
+        widget->show();
+    }
+}
+
 void Mvvms::IMvvmViewPair::collectView(QObject *view)
 {
     if(isSingle) return;
@@ -41,10 +104,21 @@ void Mvvms::IMvvmViewPair::collectView(QObject *view)
     }
 }
 
+void Mvvms::IMvvmViewPair::setViewIdle(QObject *view, bool idle)
+{
+    if (idle)
+        _idleViews.insert(view);
+    else
+        _idleViews.remove(view);
+}
+
 void Mvvms::IMvvmViewPair::onViewDestroyed(QObject *obj)
 {
     if(obj != nullptr)
+    {
         _viewObjects.removeOne(obj);
+        _idleViews.remove(obj);
+    }
 }
 
 Mvvms::IMvvmViewContainer::IMvvmViewContainer(QObject *parent)
@@ -64,6 +138,7 @@ Mvvms::IMvvmViewContainer::~IMvvmViewContainer()
         value->deleteLater();
     }
     _viewModelViewMap.clear();
+    delete _warmParent;
 }
 
 bool Mvvms::IMvvmViewContainer::collectViewModel(QObject *viewModelObj)
@@ -72,13 +147,213 @@ bool Mvvms::IMvvmViewContainer::collectViewModel(QObject *viewModelObj)
     auto viewModelKey = _viewModelNames[viewModelObj];
     if(!_viewModelViewMap.contains(viewModelKey)) return false;
     if(auto viewModel = dynamic_cast<ViewModelBase *>(viewModelObj)){
-        _viewModelViewMap[viewModelKey]->collectView(viewModel->view().value<QObject*>());
+        releaseView(viewModelKey, viewModel->view().value<QObject*>());
         ioc()->Collects(viewModel);
         return true;
     }
     return false;
 }
 
+void Mvvms::IMvvmViewContainer::setViewCache(const QString &viewModelKey, int warmCount, bool recycle)
+{
+    ViewCache &cache = _viewCaches[viewModelKey];
+    cache.warmCount = qMax(0, warmCount);
+    cache.recycle = recycle;
+
+    //不再复用时释放已缓存的
+    if (!recycle)
+    {
+        IMvvmViewPair *pair = _viewModelViewMap.value(viewModelKey);
+        while (!cache.idleViews.isEmpty())
+        {
+            QObject *view = cache.idleViews.takeLast();
+            _idleOrder.removeOne(view);
+            _idleKeys.remove(view);
+            disconnect(view, &QObject::destroyed, this, &IMvvmViewContainer::onIdleViewDestroyed);
+            if (pair != nullptr)
+            {
+                pair->collectView(view);
+            }
+        }
+    }
+
+    warmUp();
+}
+
+void Mvvms::IMvvmViewContainer::setCacheLimit(int limit)
+{
+    _cacheLimit = qMax(0, limit);
+    trimCache();
+}
+
+int Mvvms::IMvvmViewContainer::cacheLimit() const
+{
+    return _cacheLimit;
+}
+
+void Mvvms::IMvvmViewContainer::warmUp()
+{
+    if (_warmUpScheduled)
+        return;
+
+    _warmUpScheduled = true;
+    QTimer::singleShot(0, this, &IMvvmViewContainer::warmUpNext);
+}
+
+QObject *Mvvms::IMvvmViewContainer::acquireView(const QString &viewModelKey, INavigatorSetting *setting)
+{
+    qint64 startMsecs = QDateTime::currentMSecsSinceEpoch();
+    IMvvmViewPair *pair = _viewModelViewMap.value(viewModelKey);
+
+    //瞬态的 view 优先取最近回收的
+    auto cache = _viewCaches.find(viewModelKey);
+    if (!pair->isSingle && cache != _viewCaches.end() && !cache.value().idleViews.isEmpty())
+    {
+        QObject *view = cache.value().idleViews.takeLast();
+        _idleOrder.removeOne(view);
+        _idleKeys.remove(view);
+        disconnect(view, &QObject::destroyed, this, &IMvvmViewContainer::onIdleViewDestroyed);
+
+        pair->setViewIdle(view, false);
+        pair->placeView(view, setting, true);
+        watchFirstPaint(viewModelKey, view, true, startMsecs);
+
+        //池中少了一个，空闲时补足
+        warmUp();
+        return view;
+    }
+
+    QObject *view = pair->newView(setting);
+    if (view != nullptr)
+    {
+        pair->placeView(view, setting, false);
+        watchFirstPaint(viewModelKey, view, false, startMsecs);
+    }
+    return view;
+}
+
+void Mvvms::IMvvmViewContainer::releaseView(const QString &viewModelKey, QObject *view)
+{
+    IMvvmViewPair *pair = _viewModelViewMap.value(viewModelKey);
+    auto cache = _viewCaches.constFind(viewModelKey);
+    if (view == nullptr || pair->isSingle || cache == _viewCaches.constEnd() || !cache.value().recycle)
+    {
+        pair->collectView(view);
+        return;
+    }
+
+    //重置后放回池中，下次导航直接复用
+    if (auto mvvmView = dynamic_cast<MvvmView *>(view))
+    {
+        mvvmView->ResetView();
+    }
+    parkView(viewModelKey, view);
+    trimCache();
+}
+
+void Mvvms::IMvvmViewContainer::parkView(const QString &viewModelKey, QObject *view)
+{
+    //脱离原来的父窗口，避免随父窗口一起被删除
+    if (auto widget = qobject_cast<QWidget *>(view))
+    {
+        widget->hide();
+        widget->setParent(nullptr, widget->windowFlags());
+    }
+
+    if (IMvvmViewPair *pair = _viewModelViewMap.value(viewModelKey))
+    {
+        pair->setViewIdle(view, true);
+    }
+    _viewCaches[viewModelKey].idleViews.append(view);
+    _idleOrder.append(view);
+    _idleKeys.insert(view, viewModelKey);
+    connect(view, &QObject::destroyed, this, &IMvvmViewContainer::onIdleViewDestroyed);
+}
+
+void Mvvms::IMvvmViewContainer::warmUpNext()
+{
+    _warmUpScheduled = false;
+
+    for (auto it = _viewCaches.begin(); it != _viewCaches.end(); ++it)
+    {
+        IMvvmViewPair *pair = _viewModelViewMap.value(it.key());
+        if (pair == nullptr || pair->isSingle || it.value().idleViews.size() >= it.value().warmCount)
+            continue;
+
+        if (_warmSetting == nullptr)
+        {
+            _warmSetting = ioc()->Resolve<Mvvms::INavigatorSetting>();
+            if (_warmSetting == nullptr)
+                return;
+        }
+        //放在隐藏的父窗口下创建，createView 显示 view 时不会闪出顶层窗口，随后由 parkView 取下
+        if (_warmParent == nullptr)
+        {
+            _warmParent = new QWidget;
+        }
+        _warmSetting->parent = _warmParent;
+
+        QObject *view = pair->newView(_warmSetting);
+        if (view == nullptr)
+        {
+            //创建不了的类型不再预热
+            it.value().warmCount = 0;
+            continue;
+        }
+        parkView(it.key(), view);
+
+        //每轮只创建一个，避免长时间占用界面线程
+        warmUp();
+        return;
+    }
+}
+
+void Mvvms::IMvvmViewContainer::trimCache()
+{
+    //从最久未用的开始淘汰
+    int index = 0;
+    while (_idleOrder.count() > _cacheLimit && index < _idleOrder.count())
+    {
+        QObject *view = _idleOrder.at(index);
+        QString viewModelKey = _idleKeys.value(view);
+        ViewCache &cache = _viewCaches[viewModelKey];
+        if (cache.idleViews.count() <= cache.warmCount)
+        {
+            index++;
+            continue;
+        }
+
+        _idleOrder.removeAt(index);
+        _idleKeys.remove(view);
+        cache.idleViews.removeOne(view);
+        disconnect(view, &QObject::destroyed, this, &IMvvmViewContainer::onIdleViewDestroyed);
+        _viewModelViewMap.value(viewModelKey)->collectView(view);
+    }
+}
+
+void Mvvms::IMvvmViewContainer::onIdleViewDestroyed(QObject *view)
+{
+    if (!_idleKeys.contains(view))
+        return;
+
+    _viewCaches[_idleKeys.take(view)].idleViews.removeOne(view);
+    _idleOrder.removeOne(view);
+}
+
+void Mvvms::IMvvmViewContainer::watchFirstPaint(const QString &viewModelKey, QObject *view, bool recycled, qint64 startMsecs)
+{
+    //复用的 view 上次可能还没绘制过，去掉旧的监视
+    delete view->findChild<QObject *>(QLatin1String(FirstPaintWatcherName), Qt::FindDirectChildrenOnly);
+
+    QPointer<IMvvmViewContainer> container(this);
+    new FirstPaintWatcher(view, [container, viewModelKey, recycled, startMsecs]() {
+        if (container != nullptr)
+        {
+            emit container->viewFirstPainted(viewModelKey, QDateTime::currentMSecsSinceEpoch() - startMsecs, recycled);
+        }
+    });
+}
+
 Mvvms::DefaultMvvmViewPair::DefaultMvvmViewPair(QObject *parent)
     : IMvvmViewPair(parent)
 {
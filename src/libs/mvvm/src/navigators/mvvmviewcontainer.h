@@ -1,6 +1,7 @@
 #ifndef MVVMVIEWCONTAINER_H
 #define MVVMVIEWCONTAINER_H
 
+#include <QSet>
 #include "navigatorsetting.h"
 #include "../views/mvvmview.h"
 #include "../viewmodels/viewmodel.h"
@@ -15,17 +16,25 @@ namespace Mvvms {
         explicit IMvvmViewPair(QObject *parent = 0);
         ~IMvvmViewPair();
 
+        //返回正在使用的 view，缓存池中空闲的不算
         QObject *getView();
         QObject *newView(Mvvms::INavigatorSetting *setting);
+        //把取到的 view 放到导航设置指定的位置，新建和复用的 view 都经过这里
+        void placeView(QObject *view, Mvvms::INavigatorSetting *setting, bool recycled);
         void collectView(QObject *view);
+        //标记 view 进入或离开缓存池
+        void setViewIdle(QObject *view, bool idle);
 
         QString key;//这个是用于调试使用的查看该集合的类型
         bool isSingle = true;//是否单例
         std::function<QObject*(Mvvms::INavigatorSetting *setting)> createView = nullptr;//创建 view 的委托
+        //放置 view 的委托（设置父窗口、加入布局、显示等），为空时新建的 view 由 createView 放置，复用的 view 设置父窗口后显示
+        std::function<void(QObject *view, Mvvms::INavigatorSetting *setting)> placeViewFunc = nullptr;
 
     private:
         void onViewDestroyed(QObject *obj = nullptr);
         QList<QObject *> _viewObjects;//view 对象集合
+        QSet<QObject *> _idleViews;//在缓存池中空闲的 view
     };
 
     class MVVM_EXPORT IMvvmViewContainer : public IDIObj {
@@ -39,7 +48,7 @@ namespace Mvvms {
         QObject *findView() {
                     auto viewModelKey = QString::fromLatin1(static_cast<TViewModel*>(0)->staticMetaObject.className());
                     if(!_viewModelViewMap.contains(viewModelKey)) return nullptr;
-                    return _viewModelViewMap[viewModelKey].getView();
+                    return _viewModelViewMap[viewModelKey]->getView();
         }
 
         template<typename TViewModel>
@@ -59,16 +68,18 @@ namespace Mvvms {
                 return nullptr;
             }
 
-            return _viewModelViewMap[viewModelKey]->newView(setting);
+            return acquireView(viewModelKey, setting);
         }
 
         template<typename TViewModel, typename TView>
-        void bind(std::function<QObject*(Mvvms::INavigatorSetting *setting)> createViewFunc, bool isSingle) {
+        void bind(std::function<QObject*(Mvvms::INavigatorSetting *setting)> createViewFunc, bool isSingle,
+                  std::function<void(QObject *view, Mvvms::INavigatorSetting *setting)> placeViewFunc = nullptr) {
             auto viewModelKey = QString::fromLatin1(static_cast<TViewModel*>(0)->staticMetaObject.className());
             auto pair = ioc()->Resolve<IMvvmViewPair>();
             pair->isSingle = isSingle;
             pair->key = viewModelKey;
             pair->createView = createViewFunc;
+            pair->placeViewFunc = placeViewFunc;
 
             _viewModelViewMap[viewModelKey] = pair;
 
@@ -80,9 +91,49 @@ namespace Mvvms {
             }
         }
 
+        //设置瞬态 view 的缓存：warmCount 为空闲时预先创建的数量，recycle 为回收时是否重置后复用而不删除
+        template<typename TViewModel>
+        void setViewCache(int warmCount, bool recycle = true) {
+            setViewCache(QString::fromLatin1(static_cast<TViewModel*>(0)->staticMetaObject.className()), warmCount, recycle);
+        }
+        void setViewCache(const QString &viewModelKey, int warmCount, bool recycle = true);
+
+        //所有类型空闲 view 的总数上限，超出时淘汰最久未用的，预热数量以内的不淘汰
+        void setCacheLimit(int limit);
+        int cacheLimit() const;
+
+        //在空闲时把各类型的预热池补足，每轮事件循环只创建一个
+        void warmUp();
+
+    signals:
+        //一次导航从开始取 view 到 view 首次绘制的耗时
+        void viewFirstPainted(const QString &viewModelKey, qint64 msecs, bool recycled);
+
     private:
+        //某个类型 view 的缓存
+        struct ViewCache {
+            int warmCount = 0;//预热数量
+            bool recycle = false;//是否回收复用
+            QList<QObject *> idleViews;//空闲的 view，末尾为最近回收的
+        };
+
+        QObject *acquireView(const QString &viewModelKey, Mvvms::INavigatorSetting *setting);
+        void releaseView(const QString &viewModelKey, QObject *view);
+        void parkView(const QString &viewModelKey, QObject *view);
+        void warmUpNext();
+        void trimCache();
+        void onIdleViewDestroyed(QObject *view);
+        void watchFirstPaint(const QString &viewModelKey, QObject *view, bool recycled, qint64 startMsecs);
+
         QHash<QString, IMvvmViewPair *> _viewModelViewMap;
         QHash<QObject*, QString> _viewModelNames;
+        QHash<QString, ViewCache> _viewCaches;//类型--view 缓存
+        QList<QObject *> _idleOrder;//所有空闲的 view，按回收先后排列
+        QHash<QObject *, QString> _idleKeys;//空闲的 view--类型
+        int _cacheLimit = 16;//空闲 view 总数上限
+        bool _warmUpScheduled = false;//是否已安排预热
+        Mvvms::INavigatorSetting *_warmSetting = nullptr;//预热创建 view 时使用的导航设置
+        QWidget *_warmParent = nullptr;//预热创建 view 时的父窗口，始终隐藏，createView 中显示 view 也不会出现在屏幕上
     };
 
     class MVVM_EXPORT DefaultMvvmViewPair : public IMvvmViewPair
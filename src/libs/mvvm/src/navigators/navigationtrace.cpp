@@ -0,0 +1,205 @@
+#include "navigationtrace.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QThread>
+#include <algorithm>
+
+using namespace Mvvms;
+
+QAtomicInt NavigationTrace::_enabled(1);
+
+NavigationTrace::NavigationTrace()
+{
+    _spans.resize(4096);
+}
+
+NavigationTrace *NavigationTrace::instance()
+{
+    static NavigationTrace trace;
+    return &trace;
+}
+
+bool NavigationTrace::isEnabled()
+{
+    return _enabled.loadAcquire() != 0;
+}
+
+void NavigationTrace::setEnabled(bool enabled)
+{
+    _enabled.storeRelease(enabled ? 1 : 0);
+}
+
+qint64 NavigationTrace::now()
+{
+    static QElapsedTimer *timer = []() {
+        auto timer = new QElapsedTimer;
+        timer->start();
+        return timer;
+    }();
+    return timer->nsecsElapsed();
+}
+
+void NavigationTrace::setCapacity(int capacity)
+{
+    QMutexLocker locker(&_mutex);
+    _spans = QVector<Span>(qMax(1, capacity));
+    _next = 0;
+    _wrapped = false;
+}
+
+int NavigationTrace::capacity() const
+{
+    QMutexLocker locker(&_mutex);
+    return _spans.size();
+}
+
+void NavigationTrace::record(const char *name, const char *viewModel, qint64 startNs, qint64 durationNs)
+{
+    quintptr threadId = reinterpret_cast<quintptr>(QThread::currentThreadId());
+
+    QMutexLocker locker(&_mutex);
+    Span &span = _spans[_next];
+    span.name = name;
+    span.viewModel = viewModel;
+    span.startNs = startNs;
+    span.durationNs = durationNs;
+    span.threadId = threadId;
+    if (++_next == _spans.size())
+    {
+        _next = 0;
+        _wrapped = true;
+    }
+
+    StageStats &stats = _stats[StatsKey(viewModel, name)];
+    stats.count++;
+    stats.totalNs += durationNs;
+    stats.maxNs = qMax(stats.maxNs, durationNs);
+}
+
+QVector<NavigationTrace::Span> NavigationTrace::spans() const
+{
+    QMutexLocker locker(&_mutex);
+    if (!_wrapped)
+        return _spans.mid(0, _next);
+
+    return _spans.mid(_next) + _spans.mid(0, _next);
+}
+
+QHash<QString, QHash<QString, NavigationTrace::StageStats>> NavigationTrace::stats() const
+{
+    QMutexLocker locker(&_mutex);
+    QHash<QString, QHash<QString, StageStats>> result;
+    for (auto it = _stats.constBegin(); it != _stats.constEnd(); ++it)
+    {
+        //键按指针区分，不同模块中内容相同的字符串地址可能不同，按内容合并
+        StageStats &stats = result[QString::fromLatin1(it.key().first)][QString::fromLatin1(it.key().second)];
+        stats.count += it.value().count;
+        stats.totalNs += it.value().totalNs;
+        stats.maxNs = qMax(stats.maxNs, it.value().maxNs);
+    }
+    return result;
+}
+
+QString NavigationTrace::statsReport() const
+{
+    const auto allStats = stats();
+
+    //以整次导航的耗时排序，没有整次记录的按各阶段之和
+    QVector<QPair<qint64, QString>> order;
+    for (auto it = allStats.constBegin(); it != allStats.constEnd(); ++it)
+    {
+        qint64 total = 0;
+        if (it.value().contains(QStringLiteral("navigate")))
+        {
+            total = it.value().value(QStringLiteral("navigate")).totalNs;
+        }
+        else
+        {
+            for (const StageStats &stage : it.value())
+                total += stage.totalNs;
+        }
+        order.append(qMakePair(total, it.key()));
+    }
+    std::sort(order.begin(), order.end(), [](const QPair<qint64, QString> &left, const QPair<qint64, QString> &right) {
+        return left.first > right.first;
+    });
+
+    QString report;
+    report += QStringLiteral("%1 %2 %3 %4 %5\n")
+                  .arg(QStringLiteral("view model / stage"), -48)
+                  .arg(QStringLiteral("count"), 8)
+                  .arg(QStringLiteral("total ms"), 12)
+                  .arg(QStringLiteral("avg ms"), 10)
+                  .arg(QStringLiteral("max ms"), 10);
+    for (const auto &item : order)
+    {
+        report += item.second + QLatin1Char('\n');
+        const auto &stages = allStats.value(item.second);
+        for (auto it = stages.constBegin(); it != stages.constEnd(); ++it)
+        {
+            const StageStats &stage = it.value();
+            report += QStringLiteral("  %1 %2 %3 %4 %5\n")
+                          .arg(it.key(), -46)
+                          .arg(stage.count, 8)
+                          .arg(stage.totalNs / 1e6, 12, 'f', 2)
+                          .arg(stage.count > 0 ? stage.totalNs / 1e6 / stage.count : 0.0, 10, 'f', 2)
+                          .arg(stage.maxNs / 1e6, 10, 'f', 2);
+        }
+    }
+    return report;
+}
+
+QByteArray NavigationTrace::toChromeTrace() const
+{
+    const auto allSpans = spans();
+    qint64 pid = QCoreApplication::applicationPid();
+
+    QJsonArray events;
+    QHash<quintptr, int> threadIds;//线程按出现顺序编号，比原始的线程句柄易读
+    for (const Span &span : allSpans)
+    {
+        if (!threadIds.contains(span.threadId))
+            threadIds.insert(span.threadId, threadIds.size() + 1);
+
+        QJsonObject args;
+        args.insert(QStringLiteral("viewModel"), QString::fromLatin1(span.viewModel));
+
+        QJsonObject event;
+        event.insert(QStringLiteral("name"), QString::fromLatin1(span.name));
+        event.insert(QStringLiteral("cat"), QStringLiteral("navigation"));
+        event.insert(QStringLiteral("ph"), QStringLiteral("X"));
+        event.insert(QStringLiteral("ts"), span.startNs / 1000.0);
+        event.insert(QStringLiteral("dur"), span.durationNs / 1000.0);
+        event.insert(QStringLiteral("pid"), pid);
+        event.insert(QStringLiteral("tid"), threadIds.value(span.threadId));
+        event.insert(QStringLiteral("args"), args);
+        events.append(event);
+    }
+
+    QJsonObject root;
+    root.insert(QStringLiteral("traceEvents"), events);
+    root.insert(QStringLiteral("displayTimeUnit"), QStringLiteral("ms"));
+    return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
+
+bool NavigationTrace::writeChromeTrace(const QString &fileName) const
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    return file.write(toChromeTrace()) >= 0;
+}
+
+void NavigationTrace::clear()
+{
+    QMutexLocker locker(&_mutex);
+    _next = 0;
+    _wrapped = false;
+    _stats.clear();
+}
@@ -0,0 +1,103 @@
+#ifndef NAVIGATIONTRACE_H
+#define NAVIGATIONTRACE_H
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include "../mvvm_global.h"
+
+namespace Mvvms {
+
+    //导航各阶段的耗时记录。记录写入固定大小的环形缓冲区，满了覆盖最早的；
+    //同时按 view model 和阶段累计统计。可导出为 Chrome trace（chrome://tracing、Perfetto）格式
+    class MVVM_EXPORT NavigationTrace
+    {
+    public:
+        //一段耗时
+        struct Span {
+            const char *name = nullptr;//阶段名
+            const char *viewModel = nullptr;//view model 类名
+            qint64 startNs = 0;//开始时间，相对于进程内第一次取时间
+            qint64 durationNs = 0;//耗时
+            quintptr threadId = 0;//线程
+        };
+
+        //某个阶段的累计统计
+        struct StageStats {
+            int count = 0;//次数
+            qint64 totalNs = 0;//总耗时
+            qint64 maxNs = 0;//最长一次
+        };
+
+        static NavigationTrace *instance();
+
+        //是否记录，默认记录
+        static bool isEnabled();
+        static void setEnabled(bool enabled);
+
+        //单调时钟，纳秒
+        static qint64 now();
+
+        //环形缓冲区能容纳的记录数，修改时清空已有记录，默认 4096
+        void setCapacity(int capacity);
+        int capacity() const;
+
+        //记录一段耗时，name 和 viewModel 需为静态存储的字符串（字面量、类名）
+        void record(const char *name, const char *viewModel, qint64 startNs, qint64 durationNs);
+
+        //缓冲区中的记录，按时间先后
+        QVector<Span> spans() const;
+
+        //view model--阶段--统计
+        QHash<QString, QHash<QString, StageStats>> stats() const;
+
+        //按 view model 总耗时降序排列的统计表
+        QString statsReport() const;
+
+        //导出为 Chrome trace 事件格式的 JSON
+        QByteArray toChromeTrace() const;
+        bool writeChromeTrace(const QString &fileName) const;
+
+        void clear();
+
+    private:
+        NavigationTrace();
+
+        typedef QPair<const char *, const char *> StatsKey;//view model, 阶段。记录时按指针比较省去字符串比较，取统计时按内容合并
+
+        mutable QMutex _mutex;
+        QVector<Span> _spans;//环形缓冲区
+        int _next = 0;//下一条写入的位置
+        bool _wrapped = false;//是否已写满一圈
+        QHash<StatsKey, StageStats> _stats;
+
+        static QAtomicInt _enabled;
+    };
+
+    //作用域内的耗时记录，构造时开始，析构时写入 NavigationTrace
+    class TraceScope
+    {
+    public:
+        TraceScope(const char *name, const char *viewModel)
+            : _name(name), _viewModel(viewModel), _startNs(NavigationTrace::isEnabled() ? NavigationTrace::now() : -1)
+        {
+        }
+
+        ~TraceScope()
+        {
+            if (_startNs >= 0)
+                NavigationTrace::instance()->record(_name, _viewModel, _startNs, NavigationTrace::now() - _startNs);
+        }
+
+    private:
+        const char *_name;
+        const char *_viewModel;
+        qint64 _startNs;
+
+        Q_DISABLE_COPY(TraceScope)
+    };
+}
+
+#endif // NAVIGATIONTRACE_H
@@ -1,4 +1,8 @@
 #include "navigator.h"
+
+#include <QFutureWatcher>
+#include <QtConcurrent/QtConcurrentRun>
+
 using namespace Mvvms;
 
 INavigator::INavigator(IConnectorContainer *connector, IMvvmViewContainer *viewContainer, QObject *parent)
@@ -16,6 +20,10 @@ INavigator::~INavigator()
 
 void INavigator::Collect(QObject *viewModelObj)
 {
+    //离开时作废未完成的异步准备
+    if(auto viewModel = dynamic_cast<ViewModelBase *>(viewModelObj)){
+        viewModel->cancelLoading();
+    }
     if(_viewContainer->collectViewModel(viewModelObj)){
         _connector->Remove(viewModelObj);
     }
@@ -33,6 +41,26 @@ INavigatorSetting *INavigator::getSetting(QWidget *parent)
     return setting;
 }
 
+void INavigator::fetchAsync(const char *viewModelName, const std::function<QVariant ()> &fetcher, const std::function<void (QVariant *)> &finish)
+{
+    auto watcher = new QFutureWatcher<QVariant>(this);
+    QSharedPointer<bool> handled(new bool(false));
+    connect(watcher, &QFutureWatcher<QVariant>::finished, this, [watcher, finish, handled]() {
+        *handled = true;
+        QVariant data = watcher->result();
+        finish(&data);
+        watcher->deleteLater();
+    });
+    connect(watcher, &QObject::destroyed, [finish, handled]() {
+        if (!*handled)
+            finish(nullptr);
+    });
+    watcher->setFuture(QtConcurrent::run([viewModelName, fetcher]() {
+        TraceScope scope("fetch", viewModelName);
+        return fetcher();
+    }));
+}
+
 DefaultNavigator::DefaultNavigator(IConnectorContainer *connector, IMvvmViewContainer *viewContainer, QObject *parent)
     :   INavigator(connector, viewContainer, parent)
 {
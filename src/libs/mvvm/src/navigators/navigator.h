@@ -2,6 +2,9 @@
 #define NAVIGATOR_H
 
 #include <QObject>
+#include <QFuture>
+#include <QFutureInterface>
+#include <QPointer>
 #include <QMetaType>
 #include <QSharedPointer>
 #include <QVariant>
@@ -14,6 +17,7 @@
 #include "../views/mvvmview.h"
 #include "../viewmodels/viewmodel.h"
 #include "mvvmviewcontainer.h"
+#include "navigationtrace.h"
 #include "../mvvm_global.h"
 
 namespace Mvvms {
@@ -49,21 +53,21 @@ namespace Mvvms {
 
         template<typename TViewModel>
         void Navigate(Mvvms::INavigatorSetting *setting) {
-            auto viewModel = ioc()->Resolve<TViewModel>();
+            auto viewModel = resolveViewModel<TViewModel>();
             Execute(viewModel, setting);
         }
 
         template<typename TViewModel, typename TParam>
         void Navigate(TParam param, Mvvms::INavigatorSetting *setting) {
-            auto viewModel = ioc()->Resolve<TViewModel>();
+            auto viewModel = resolveViewModel<TViewModel>();
             auto paramVar = QVariant::fromValue(param);
-            viewModel->prepareParam(paramVar);
+            prepareViewModel(viewModel, paramVar);
             Execute(viewModel, setting);
         }
 
         template<typename TViewModel, typename TResult>
         void Navigate(Mvvms::INavigatorSetting *setting) {
-            auto viewModel = ioc()->Resolve<TViewModel>();
+            auto viewModel = resolveViewModel<TViewModel>();
             Execute(viewModel, setting);
             QVariant result = viewModel->result;
             return result.value<TResult>();
@@ -71,14 +75,70 @@ namespace Mvvms {
 
         template<typename TViewModel, typename TParam, typename TResult>
         TResult Navigate(TParam param, Mvvms::INavigatorSetting *setting) {
-            auto viewModel = ioc()->Resolve<TViewModel>();
+            auto viewModel = resolveViewModel<TViewModel>();
             auto paramVar = QVariant::fromValue(param);
-            viewModel->prepareParam(paramVar);
+            prepareViewModel(viewModel, paramVar);
             Execute(viewModel, setting);
             QVariant result = viewModel->result;
             return result.value<TResult>();
         }
 
+        template<typename TViewModel>
+        QFuture<TViewModel *> NavigateAsync(QWidget *parent = nullptr) {
+            return NavigateAsync<TViewModel, QVariant>(QVariant(), getSetting(parent));
+        }
+
+        template<typename TViewModel, typename TParam>
+        QFuture<TViewModel *> NavigateAsync(TParam param, QWidget *parent = nullptr) {
+            return NavigateAsync<TViewModel, TParam>(param, getSetting(parent));
+        }
+
+        //异步导航：view 立即显示（view model 处于加载状态，view 可显示占位内容），
+        //view model 的 fetcher 在工作线程中取数，完成后回到界面线程 prepareFetched。
+        //返回的 future 在准备完成后给出 view model；调用 cancel、回收 view model 或再次导航到同一 view model 时作废
+        template<typename TViewModel, typename TParam>
+        QFuture<TViewModel *> NavigateAsync(TParam param, Mvvms::INavigatorSetting *setting) {
+            QFutureInterface<TViewModel *> promise;
+            promise.reportStarted();
+
+            auto viewModel = resolveViewModel<TViewModel>();
+            if (viewModel == nullptr) {
+                promise.reportCanceled();
+                promise.reportFinished();
+                return promise.future();
+            }
+
+            auto paramVar = QVariant::fromValue(param);
+            auto fetcher = viewModel->fetcherForParam(paramVar);
+            int ticket = viewModel->beginLoading();
+            Execute(viewModel, setting);
+
+            const char *viewModelName = static_cast<TViewModel*>(0)->staticMetaObject.className();
+            QPointer<TViewModel> target(viewModel);
+            std::function<void(QVariant *)> finish = [promise, target, paramVar, ticket, viewModelName](QVariant *data) mutable {
+                bool current = !target.isNull() && target->isLoading(ticket);
+                if (data == nullptr || promise.isCanceled() || !current) {
+                    if (current)
+                        target->cancelLoading();
+                    promise.reportCanceled();
+                    promise.reportFinished();
+                    return;
+                }
+                TraceScope scope("prepare", viewModelName);
+                target->prepareFetchedParam(paramVar, *data);
+                promise.reportResult(target.data());
+                promise.reportFinished();
+            };
+
+            if (fetcher == nullptr) {
+                QVariant data = paramVar;
+                finish(&data);
+            } else {
+                fetchAsync(viewModelName, fetcher, finish);
+            }
+            return promise.future();
+        }
+
         template<typename TViewModel>
         TViewModel *Call(QWidget *parent = nullptr) {
             return Call<TViewModel>(getSetting(parent));
@@ -91,16 +151,16 @@ namespace Mvvms {
 
         template<typename TViewModel>
         TViewModel *Call(Mvvms::INavigatorSetting *setting) {
-            auto viewModel = ioc()->Resolve<TViewModel>();
+            auto viewModel = resolveViewModel<TViewModel>();
             Execute(viewModel, setting, false);
             return viewModel;
         }
 
         template<typename TViewModel, typename TParam>
         TViewModel *Call(TParam param, Mvvms::INavigatorSetting *setting) {
-            auto viewModel = ioc()->Resolve<TViewModel>();
+            auto viewModel = resolveViewModel<TViewModel>();
             auto paramVar = QVariant::fromValue(param);
-            viewModel->prepareParam(paramVar);
+            prepareViewModel(viewModel, paramVar);
             Execute(viewModel, setting, false);
             return viewModel;
         }
@@ -110,9 +170,17 @@ namespace Mvvms {
             _viewContainer->bind<TViewModel, TView>(createViewFunc, true);
         }
 
+        //placeViewFunc 放置 view（加入布局、显示等），新建和回收复用的 view 都会经过它，见 IMvvmViewPair::placeViewFunc
         template<typename TViewModel, typename TView>
-        void BindTransient(std::function<QObject*(Mvvms::INavigatorSetting *setting)> createViewFunc) {
-            _viewContainer->bind<TViewModel, TView>(createViewFunc, false);
+        void BindTransient(std::function<QObject*(Mvvms::INavigatorSetting *setting)> createViewFunc,
+                           std::function<void(QObject *view, Mvvms::INavigatorSetting *setting)> placeViewFunc = nullptr) {
+            _viewContainer->bind<TViewModel, TView>(createViewFunc, false, placeViewFunc);
+        }
+
+        //设置瞬态 view 的预热数量和是否回收复用，见 IMvvmViewContainer::setViewCache
+        template<typename TViewModel>
+        void SetViewCache(int warmCount, bool recycle = true) {
+            _viewContainer->setViewCache<TViewModel>(warmCount, recycle);
         }
 
         template<typename TViewModel>
@@ -131,10 +199,36 @@ namespace Mvvms {
 
     protected:
 
+        //解析 view model，记录耗时
+        template<typename TViewModel>
+        TViewModel *resolveViewModel() {
+            TraceScope scope("resolve", static_cast<TViewModel*>(0)->staticMetaObject.className());
+            return ioc()->Resolve<TViewModel>();
+        }
+
+        //用导航参数准备 view model，记录耗时
+        template<typename TViewModel>
+        void prepareViewModel(TViewModel *viewModel, QVariant &param) {
+            TraceScope scope("prepare", static_cast<TViewModel*>(0)->staticMetaObject.className());
+            viewModel->prepareParam(param);
+        }
+
+        //各阶段的耗时记录到 NavigationTrace：绑定连接器、创建 view、view 加载 view model，以及整个过程
         template<typename TViewModel>
         void Execute(TViewModel *viewModel, Mvvms::INavigatorSetting *setting, bool isNavigate = true) {
-            _connector->Add(viewModel);
-            auto viewObj = _viewContainer->callView<TViewModel>(viewModel, setting);
+            const char *viewModelName = static_cast<TViewModel*>(0)->staticMetaObject.className();
+            TraceScope navigateScope("navigate", viewModelName);
+
+            {
+                TraceScope scope("bind", viewModelName);
+                _connector->Add(viewModel);
+            }
+
+            QObject *viewObj = nullptr;
+            {
+                TraceScope scope("createView", viewModelName);
+                viewObj = _viewContainer->callView<TViewModel>(viewModel, setting);
+            }
 
             if (viewObj == nullptr)
                 return ;
@@ -142,12 +236,16 @@ namespace Mvvms {
             auto viewVar = QVariant::fromValue(viewObj);
             viewModel->setView(viewVar);
             if(auto mvvmView = dynamic_cast<MvvmView*>(viewObj)){
+                TraceScope scope("loadViewModel", viewModelName);
                 mvvmView->LoadViewModel(viewModel, setting);
             }
         }
 
         Mvvms::INavigatorSetting *getSetting(QWidget *parent);
 
+        //在工作线程中执行 fetcher，完成后在界面线程以结果调用 finish；导航器先析构时以空指针调用
+        void fetchAsync(const char *viewModelName, const std::function<QVariant()> &fetcher, const std::function<void(QVariant *data)> &finish);
+
     private:
 
         IConnectorContainer *_connector;
@@ -1,8 +1,24 @@
 #include "propertybase.h"
+#include "../viewmodels/viewmodel.h"
+
+Mvvms::PropertyNotify::PropertyNotify(QObject *parent)
+    :   QObject(parent)
+{
+
+}
+
+void Mvvms::PropertyNotify::notify()
+{
+    auto viewModel = qobject_cast<ViewModelBase *>(parent());
+    if (viewModel != nullptr && viewModel->deferNotify(this))
+        return;
+
+    send();
+}
 
 template<typename T>
 Mvvms::PropertyBase<T>::PropertyBase(QObject *parent)
-    :   QObject(parent)
+    :   PropertyNotify(parent)
 {
 
 }
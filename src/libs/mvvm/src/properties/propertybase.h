@@ -7,9 +7,28 @@
 #include "../mvvm_global.h"
 
 namespace Mvvms {
+    class ViewModelBase;
+
+    //属性通知基类，父对象为处于批量更新中的 ViewModelBase 时，通知被延迟合并
+    class MVVM_EXPORT PropertyNotify : public QObject
+    {
+    public:
+        explicit PropertyNotify(QObject *parent = 0);
+
+    protected:
+        //立即发送通知，或交给所属 ViewModelBase 延迟发送
+        void notify();
+
+        virtual void send() = 0;
+
+    private:
+        bool _pending = false;//已在 ViewModelBase 的待发送队列中
+        friend class ViewModelBase;
+    };
+
     //通用属性模板
     template <typename T>
-    class MVVM_EXPORT PropertyBase : public QObject
+    class MVVM_EXPORT PropertyBase : public PropertyNotify
     {
     public:
         explicit PropertyBase(QObject *parent = 0);
@@ -20,18 +39,21 @@ namespace Mvvms {
         void setAndSend(const T &value) {
             if (!_settingFlag)//正在设置的标志，防止信号循环
             {
+                if (_initialized && _baseValue == value)//值未变化，不发送通知；首次设置即使等于默认值也要通知
+                    return;
+
+                _initialized = true;
                 _settingFlag = true;
                 _baseValue = value;
-                send();
+                notify();
                 _settingFlag = false;
             }
         }
 
-        virtual void send() = 0;
-
     private:
-        T _baseValue;
+        T _baseValue{};
         bool _settingFlag = false;//正在设置的标志，防止信号循环
+        bool _initialized = false;//是否被设置过值
     };
 
     //界面互相通知属性 QString
@@ -1,4 +1,7 @@
 #include "viewmodel.h"
+#include "../properties/propertybase.h"
+
+#include <QTimer>
 
 using namespace Mvvms;
 
@@ -34,3 +37,127 @@ void ViewModelBase::prepare(QVariant &param)
 {
     Q_UNUSED(param)
 }
+
+std::function<QVariant()> ViewModelBase::fetcher(const QVariant &param)
+{
+    Q_UNUSED(param)
+    return nullptr;
+}
+
+void ViewModelBase::prepareFetched(QVariant &data)
+{
+    prepare(data);
+}
+
+std::function<QVariant()> ViewModelBase::fetcherForParam(const QVariant &param)
+{
+    return fetcher(param);
+}
+
+void ViewModelBase::prepareFetchedParam(const QVariant &param, QVariant &data)
+{
+    prepareFetched(data);
+    _param = param;
+
+    if (_loading)
+    {
+        _loading = false;
+        emit loadingChanged(false);
+    }
+}
+
+int ViewModelBase::beginLoading()
+{
+    _loadTicket++;
+    if (!_loading)
+    {
+        _loading = true;
+        emit loadingChanged(true);
+    }
+    return _loadTicket;
+}
+
+void ViewModelBase::cancelLoading()
+{
+    //编号变化后，未完成的加载回来时作废
+    _loadTicket++;
+    if (_loading)
+    {
+        _loading = false;
+        emit loadingChanged(false);
+    }
+}
+
+bool ViewModelBase::isLoading() const
+{
+    return _loading;
+}
+
+bool ViewModelBase::isLoading(int ticket) const
+{
+    return _loading && ticket == _loadTicket;
+}
+
+void ViewModelBase::beginUpdate()
+{
+    _updateDepth++;
+}
+
+void ViewModelBase::endUpdate()
+{
+    if (_updateDepth <= 0)
+        return;
+
+    _updateDepth--;
+    if (_updateDepth > 0 || _pendingNotifies.isEmpty() || _flushScheduled)
+        return;
+
+    _flushScheduled = true;
+    QTimer::singleShot(0, this, &ViewModelBase::flushNotify);
+}
+
+bool ViewModelBase::isUpdating() const
+{
+    return _updateDepth > 0;
+}
+
+void ViewModelBase::notifyAll()
+{
+    for (QObject *child : children())
+    {
+        if (auto property = dynamic_cast<PropertyNotify *>(child))
+            property->notify();
+    }
+}
+
+bool ViewModelBase::deferNotify(PropertyNotify *property)
+{
+    if (_updateDepth <= 0 && !_flushScheduled)
+        return false;
+
+    //同一属性在一次批量更新中只通知一次，发送时取最新值
+    if (!property->_pending)
+    {
+        property->_pending = true;
+        _pendingNotifies.append(property);
+    }
+    return true;
+}
+
+void ViewModelBase::flushNotify()
+{
+    _flushScheduled = false;
+    if (_updateDepth > 0)//又开始了新的批量更新，等其结束时再发送
+        return;
+
+    const auto pending = _pendingNotifies;
+    _pendingNotifies.clear();
+    for (const auto &property : pending)
+    {
+        if (property.isNull())
+            continue;
+
+        property->_pending = false;
+        property->send();
+    }
+}
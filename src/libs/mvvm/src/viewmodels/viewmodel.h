@@ -2,11 +2,16 @@
 #define VIEWMODEL_H
 
 #include <QObject>
+#include <QPointer>
+#include <QVector>
+#include <functional>
 #include "ioc.h"
 #include "../mvvm_global.h"
 
 namespace Mvvms {
 
+class PropertyNotify;
+
 class MVVM_EXPORT ViewModelBase : public IDIObj {
     Q_OBJECT
 public:
@@ -15,11 +20,66 @@ public:
     virtual void afterLoadViewModel();
     QVariant view();
     void setView(QVariant &value);
+
+    //开始批量更新，期间子属性的变更通知被延迟，每个属性只保留一次
+    void beginUpdate();
+    //结束批量更新，最外层结束后在下一次事件循环统一发送通知
+    void endUpdate();
+    //是否处于批量更新中
+    bool isUpdating() const;
+    //重新通知所有属性的当前值，复用的 view 绑定到本 view model 后据此刷新界面
+    void notifyAll();
+
+    //异步导航：返回在工作线程中执行的取数函数，没有耗时的准备时为空
+    std::function<QVariant()> fetcherForParam(const QVariant &param);
+    //异步导航：取数完成后在界面线程调用，交给 prepareFetched 并结束加载
+    void prepareFetchedParam(const QVariant &param, QVariant &data);
+    //开始加载，返回本次加载的编号，之前未完成的加载作废
+    int beginLoading();
+    //取消正在进行的加载
+    void cancelLoading();
+    //是否正在加载
+    bool isLoading() const;
+    //编号为 ticket 的加载是否仍然有效
+    bool isLoading(int ticket) const;
+
+    //批量更新守卫，构造时 beginUpdate，析构时 endUpdate
+    class UpdateGuard {
+    public:
+        explicit UpdateGuard(ViewModelBase *viewModel) : _viewModel(viewModel) { _viewModel->beginUpdate(); }
+        ~UpdateGuard() { _viewModel->endUpdate(); }
+    private:
+        ViewModelBase *_viewModel;
+        Q_DISABLE_COPY(UpdateGuard)
+    };
+
+signals:
+    //加载状态变化，view 可据此显示占位内容
+    void loadingChanged(bool loading);
+
 protected:
     virtual void prepare(QVariant &param);
+    //返回异步导航时在工作线程中执行的取数函数。函数不能捕获 this，也不能访问界面，只依赖参数和线程安全的对象，
+    //返回值交给 prepareFetched。默认为空，此时直接用参数调用 prepareFetched
+    virtual std::function<QVariant()> fetcher(const QVariant &param);
+    //在界面线程中用取到的数据准备 view model，默认交给 prepare
+    virtual void prepareFetched(QVariant &data);
 
     QVariant _view;
     QVariant _param;
+
+private:
+    //批量更新中时记录待发送的属性，返回 true 表示通知已延迟
+    bool deferNotify(PropertyNotify *property);
+    void flushNotify();
+
+    int _updateDepth = 0;//批量更新嵌套层数
+    bool _flushScheduled = false;//是否已安排在下一次事件循环发送
+    bool _loading = false;//是否正在异步加载
+    int _loadTicket = 0;//最近一次加载的编号
+    QVector<QPointer<PropertyNotify>> _pendingNotifies;//待发送通知的属性
+
+    friend class PropertyNotify;
 };
 typedef QSharedPointer<ViewModelBase> ViewModelBasePtr;
 }
@@ -1,4 +1,5 @@
 #include "mvvmview.h"
+#include "../viewmodels/viewmodel.h"
 using namespace Mvvms;
 
 MvvmView::MvvmView(){
@@ -17,6 +18,14 @@ bool MvvmView::LoadViewModel(QObject *viewModel, INavigatorSetting *setting)
     auto flag = loadViewModel(viewModel, setting);
     _viewModelObject = viewModel;
     _setting = setting;
+
+    //属性只在值变化时通知，复用的 view 还显示着上一个 view model 的值，这里把新 view model 的值全部推送一遍
+    if (_recycled)
+    {
+        _recycled = false;
+        if (auto viewModelBase = qobject_cast<ViewModelBase *>(viewModel))
+            viewModelBase->notifyAll();
+    }
     return flag;
 }
 
@@ -25,6 +34,18 @@ void MvvmView::ShowView()
     showView();
 }
 
+void MvvmView::ResetView()
+{
+    resetView();
+    //view model 由容器回收，这里只回收导航设置
+    if (auto idObj = dynamic_cast<IDIObj *>(_viewModelObject)){
+        idObj->ioc()->Collects(_setting);
+    }
+    _viewModelObject = nullptr;
+    _setting = nullptr;
+    _recycled = true;
+}
+
 QObject *MvvmView::viewModelObject()
 {
     return _viewModelObject;
@@ -35,3 +56,8 @@ void MvvmView::showView()
 
 }
 
+void MvvmView::resetView()
+{
+
+}
+
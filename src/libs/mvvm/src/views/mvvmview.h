@@ -11,14 +11,21 @@ namespace Mvvms {
 
         bool LoadViewModel(QObject *viewModel, INavigatorSetting *setting);
         void ShowView();
+        //view 被回收复用前调用，断开与原 view model 的关联
+        void ResetView();
         QObject* viewModelObject();
 
     protected:
         virtual bool loadViewModel(QObject* viewModel, INavigatorSetting *setting) = 0;
         virtual void showView();
+        //回收时清理界面状态，下次 loadViewModel 时会绑定新的 view model，之后新 view model 的所有属性会重新通知一次
+        virtual void resetView();
 
-        QObject *_viewModelObject;
+        QObject *_viewModelObject = nullptr;
         INavigatorSetting *_setting = nullptr;
+
+    private:
+        bool _recycled = false;//是否被回收过，再次加载时需要重新推送属性
     };
 
 }
@@ -0,0 +1,156 @@
+#ifndef TEST_CONNECTORCONTAINER_H
+#define TEST_CONNECTORCONTAINER_H
+
+#include <QtTest>
+#include "connectorcontainer.h"
+#include "testutils.h"
+
+namespace ConnectorTest {
+    class ViewModel : public QObject
+    {
+        Q_OBJECT
+    signals:
+        void changed();
+    };
+
+    class View : public QObject
+    {
+        Q_OBJECT
+    public slots:
+        void onChanged() { ++count; }
+    public:
+        int count = 0;
+    };
+
+    //与父类 ViewModel 组成关系的子类
+    class ChildViewModel : public ViewModel
+    {
+        Q_OBJECT
+    public slots:
+        void onChanged() { ++count; }
+    public:
+        int count = 0;
+    };
+}
+
+class Test_ConnectorContainer : public QObject
+{
+    Q_OBJECT
+
+private:
+    //绑定 ViewModel 与 View 的信号，解绑时断开
+    static void bindPair(Connector::IConnectorContainer &container)
+    {
+        using namespace ConnectorTest;
+        container.binding<ViewModel, View>(
+            [](QObject *obj1, QObject *obj2) {
+                return bool(QObject::connect(static_cast<ViewModel *>(obj1), &ViewModel::changed,
+                                             static_cast<View *>(obj2), &View::onChanged));
+            },
+            [](QObject *obj1, QObject *obj2) {
+                return QObject::disconnect(static_cast<ViewModel *>(obj1), &ViewModel::changed,
+                                           static_cast<View *>(obj2), &View::onChanged);
+            });
+    }
+
+    //打开再关闭一组界面，交替使用显式移除和析构清理
+    static void openClose(Connector::IConnectorContainer &container, int cycle)
+    {
+        ConnectorTest::ViewModel *viewModel = new ConnectorTest::ViewModel;
+        ConnectorTest::View *view = new ConnectorTest::View;
+        container.Add(viewModel);
+        container.Add(view);
+        emit viewModel->changed();
+        if (cycle % 2 == 0)
+        {
+            container.Remove(view);
+            container.Remove(viewModel);
+        }
+        delete view;
+        delete viewModel;
+    }
+
+private slots:
+    //两端对象都能被解绑
+    void removeUnbindsBothSides()
+    {
+        Connector::DefaultConnectorContainer container;
+        bindPair(container);
+        ConnectorTest::ViewModel viewModel;
+        ConnectorTest::View view;
+        container.Add(&viewModel);
+        container.Add(&view);
+        emit viewModel.changed();
+        QCOMPARE(view.count, 1);
+
+        container.Remove(&view);
+        emit viewModel.changed();
+        QCOMPARE(view.count, 1);
+    }
+
+    //一端类型继承自另一端时，子类对象按精确类型落到自己那一端
+    void derivedPairBinds()
+    {
+        using namespace ConnectorTest;
+        Connector::DefaultConnectorContainer container;
+        container.binding<ViewModel, ChildViewModel>(
+            [](QObject *obj1, QObject *obj2) {
+                return bool(QObject::connect(static_cast<ViewModel *>(obj1), &ViewModel::changed,
+                                             static_cast<ChildViewModel *>(obj2), &ChildViewModel::onChanged));
+            });
+        ViewModel viewModel;
+        ChildViewModel child;
+        container.Add(&viewModel);
+        container.Add(&child);
+        emit viewModel.changed();
+        QCOMPARE(child.count, 1);
+    }
+
+    //已加入的对象再次加入时，仍会加入之后才声明的关系，已有的关系不重复绑定
+    void pairDeclaredAfterAdd()
+    {
+        Connector::DefaultConnectorContainer container;
+        ConnectorTest::ViewModel viewModel;
+        ConnectorTest::View view;
+        container.Add(&viewModel);
+        container.Add(&view);
+
+        bindPair(container);
+        container.Add(&viewModel);
+        container.Add(&view);
+        emit viewModel.changed();
+        QCOMPARE(view.count, 1);
+
+        container.Add(&viewModel);
+        container.Add(&view);
+        emit viewModel.changed();
+        QCOMPARE(view.count, 2);
+    }
+
+    //长时间反复打开关闭后内存不增长
+    void soakOpenClose()
+    {
+        const int cycles = 100000;
+        Connector::DefaultConnectorContainer container;
+        bindPair(container);
+
+        //预热，让分配器和哈希表达到稳定大小
+        for (int i = 0; i < cycles / 10; ++i)
+            openClose(container, i);
+        const qint64 before = residentMemory();
+        if (before < 0)
+            QSKIP("resident memory is not available on this platform");
+
+        QBENCHMARK_ONCE {
+            for (int i = 0; i < cycles; ++i)
+                openClose(container, i);
+        }
+
+        const qint64 after = residentMemory();
+        qDebug() << "resident memory before" << before / 1024 << "KiB, after" << after / 1024 << "KiB";
+        //泄漏每轮至少几十字节，10 万轮会超过数 MB
+        QVERIFY2(after - before < 1024 * 1024, "memory grows with open/close cycles");
+    }
+};
+
+#endif // TEST_CONNECTORCONTAINER_H
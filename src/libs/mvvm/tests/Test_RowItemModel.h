@@ -0,0 +1,481 @@
+#ifndef TEST_ROWITEMMODEL_H
+#define TEST_ROWITEMMODEL_H
+
+#include <QtTest>
+#include <QFutureWatcher>
+#include <algorithm>
+#include <numeric>
+#include "rowitemmodel.h"
+#include "rowitemdatasource.h"
+#include "rowitem.h"
+#include "testutils.h"
+
+class Test_RowItemModel : public QObject
+{
+    Q_OBJECT
+
+private:
+    //生成 id、pid、name 三列的树形结果集，0 号为根节点，每个节点 10 个子节点
+    static QList<QVariantList> treeSource(int count)
+    {
+        QList<QVariantList> source;
+        source.reserve(count);
+        source.append(QVariantList{0, -1, QStringLiteral("root")});
+        for (int i = 1; i < count; ++i)
+            source.append(QVariantList{i, (i - 1) / 10, QStringLiteral("node %1").arg(i)});
+        return source;
+    }
+
+    static int countItems(const RowItem *item)
+    {
+        int count = item->childCount();
+        for (int i = 0; i < item->childCount(); ++i)
+            count += countItems(item->child(i));
+        return count;
+    }
+
+    //id、group、value 三列的表格
+    static QStringList tableHeaders()
+    {
+        return QStringList{QStringLiteral("id"), QStringLiteral("group"), QStringLiteral("value")};
+    }
+
+    static QVariantList tableRow(int id, const QString &group, const QVariant &value)
+    {
+        return QVariantList{id, group, value};
+    }
+
+    //在根节点下逐行追加顶层行，每行发出各自的插入信号
+    static void appendRows(RowItemModel &model, const QList<QVariantList> &rows)
+    {
+        for (const QVariantList &row : rows)
+        {
+            RowItem *item = new RowItem(&model);
+            item->setItemData(row);
+            model.root()->addChild(item);
+        }
+    }
+
+    //按显示顺序返回顶层行的 id
+    static QList<int> viewIds(const RowItemModel &model)
+    {
+        QList<int> ids;
+        for (int row = 0; row < model.rowCount(); ++row)
+            ids.append(model.index(row, 0).data().toInt());
+        return ids;
+    }
+
+    //信号中的行范围，parent 为无效索引时是顶层行
+    static QPair<int, int> rowRange(const QList<QVariant> &arguments)
+    {
+        return qMakePair(arguments.at(1).toInt(), arguments.at(2).toInt());
+    }
+
+    //每页 10 行、永远取不完的分页数据源，每个节点都可能有子项
+    static QSharedPointer<FunctionRowItemDataSource> pagedSource()
+    {
+        QSharedPointer<FunctionRowItemDataSource> dataSource(new FunctionRowItemDataSource);
+        dataSource->rows = 10;
+        dataSource->fetchFunc = [](const QVariantList &, int offset, int limit) {
+            QList<QVariantList> rows;
+            for (int i = 0; i < limit; ++i)
+                rows.append(QVariantList{offset + i, -1, QStringLiteral("row %1").arg(offset + i)});
+            return rows;
+        };
+        dataSource->hasChildrenFunc = [](const RowItem *) { return true; };
+        return dataSource;
+    }
+
+    //加载节点的第一页并等后台预取完成，此时没有人等待这一页
+    static void fetchAndPrefetch(RowItemModel &model, const QModelIndex &parent)
+    {
+        model.fetchMore(parent);
+        QCOMPARE(model.rowCount(parent), 10);
+        const auto watchers = model.findChildren<QFutureWatcherBase *>();
+        QVERIFY(!watchers.isEmpty());
+        for (QFutureWatcherBase *watcher : watchers)
+            QTRY_VERIFY(watcher->isFinished());
+    }
+
+    static int prefetchCount(const RowItemModel &model)
+    {
+        QCoreApplication::sendPostedEvents(Q_NULLPTR, QEvent::DeferredDelete);
+        return model.findChildren<QFutureWatcherBase *>().size();
+    }
+
+private slots:
+    //分页过程中清空、更换数据源或删除节点时，已完成的预取随状态一起释放
+    void prefetchReleasedWithState()
+    {
+        RowItemModel model(QStringList{QStringLiteral("id"), QStringLiteral("pid"), QStringLiteral("name")});
+        model.setDataSource(pagedSource());
+
+        fetchAndPrefetch(model, QModelIndex());
+        QCOMPARE(prefetchCount(model), 1);
+        model.clear();
+        QCOMPARE(prefetchCount(model), 0);
+
+        fetchAndPrefetch(model, QModelIndex());
+        model.setDataSource(pagedSource());
+        QCOMPARE(prefetchCount(model), 0);
+
+        //子节点的预取在节点删除时释放，根节点的预取仍保留
+        fetchAndPrefetch(model, QModelIndex());
+        fetchAndPrefetch(model, model.index(0, 0));
+        QCOMPARE(prefetchCount(model), 2);
+        QVERIFY(model.removeRows(0, 1));
+        QCOMPARE(prefetchCount(model), 1);
+
+        //剩下的预取仍能用于下一页
+        model.fetchMore(QModelIndex());
+        QCOMPARE(model.rowCount(), 19);
+    }
+
+    //多列排序，靠前的列优先，全部相同时保持原来的先后
+    void sortByColumns()
+    {
+        RowItemModel model(tableHeaders());
+        appendRows(model, {tableRow(1, QStringLiteral("b"), 3), tableRow(2, QStringLiteral("a"), 2),
+                           tableRow(3, QStringLiteral("b"), 1), tableRow(4, QStringLiteral("a"), 2),
+                           tableRow(5, QStringLiteral("c"), 0)});
+        QSignalSpy layoutSpy(&model, &QAbstractItemModel::layoutChanged);
+
+        model.sortBy({RowItemModel::SortColumn{1, Qt::AscendingOrder}, RowItemModel::SortColumn{2, Qt::DescendingOrder}});
+        QCOMPARE(viewIds(model), (QList<int>{2, 4, 1, 3, 5}));
+        QCOMPARE(layoutSpy.count(), 1);
+
+        model.sort(-1);
+        QCOMPARE(viewIds(model), (QList<int>{1, 2, 3, 4, 5}));
+    }
+
+    void sortLargeTable_data()
+    {
+        QTest::addColumn<int>("count");
+        QTest::newRow("serial") << 1000;
+        QTest::newRow("parallel") << 200000;
+    }
+
+    //行数超过并行阈值时分段排序后归并，结果与稳定排序一致
+    void sortLargeTable()
+    {
+        QFETCH(int, count);
+        QList<QVariantList> rows;
+        rows.reserve(count);
+        for (int i = 0; i < count; ++i)
+            rows.append(QVariantList{i, (i * 7919) % 13, (i * 6271) % 1000});
+
+        RowItemModel model(tableHeaders());
+        model.beginBulkLoad();
+        appendRows(model, rows);
+        model.endBulkLoad();
+        model.sortBy({RowItemModel::SortColumn{1, Qt::AscendingOrder}, RowItemModel::SortColumn{2, Qt::DescendingOrder}});
+
+        QList<int> expected;
+        expected.reserve(count);
+        for (int i = 0; i < count; ++i)
+            expected.append(i);
+        std::stable_sort(expected.begin(), expected.end(), [&rows](int left, int right) {
+            const QVariantList &l = rows.at(left);
+            const QVariantList &r = rows.at(right);
+            if (l.at(1).toInt() != r.at(1).toInt())
+                return l.at(1).toInt() < r.at(1).toInt();
+            return l.at(2).toInt() > r.at(2).toInt();
+        });
+        QCOMPARE(viewIds(model), expected);
+    }
+
+    //过滤后显示位置与节点互相转换，子项的父索引是父行的显示位置
+    void filterMapsRows()
+    {
+        RowItemModel model(tableHeaders());
+        appendRows(model, {tableRow(1, QStringLiteral("a"), 1), tableRow(2, QStringLiteral("b"), 2),
+                           tableRow(3, QStringLiteral("a"), 3), tableRow(4, QStringLiteral("b"), 4),
+                           tableRow(5, QStringLiteral("a"), 5)});
+        RowItem *child = new RowItem(&model);
+        child->setItemData(tableRow(30, QStringLiteral("c"), 0));
+        model.root()->child(2)->addChild(child);
+
+        model.setFilter([](const RowItem *item) { return item->value(1).toString() == QLatin1String("a"); });
+        QCOMPARE(viewIds(model), (QList<int>{1, 3, 5}));
+        for (int row = 0; row < model.rowCount(); ++row)
+        {
+            QModelIndex index = model.index(row, 0);
+            QCOMPARE(model.indexFromItem(model.itemFromIndex(index)), index);
+        }
+        QVERIFY(!model.indexFromItem(model.root()->child(1)).isValid());
+        QVERIFY(!model.indexFromItem(model.root()->child(3)).isValid());
+
+        QModelIndex childIndex = model.indexFromItem(child);
+        QCOMPARE(childIndex.row(), 0);
+        QCOMPARE(model.parent(childIndex), model.index(1, 0));
+        QCOMPARE(model.rowCount(model.index(1, 0)), 1);
+
+        //排序与过滤同时生效
+        model.sort(2, Qt::DescendingOrder);
+        QCOMPARE(viewIds(model), (QList<int>{5, 3, 1}));
+        QCOMPARE(model.parent(model.indexFromItem(child)), model.index(1, 0));
+
+        model.setFilter(nullptr);
+        QCOMPARE(viewIds(model), (QList<int>{5, 4, 3, 2, 1}));
+    }
+
+    //修改一行的值后只发出这一行的移动、删除或插入信号，持久索引随之更新
+    void refilterAfterSetValue()
+    {
+        RowItemModel model(tableHeaders());
+        appendRows(model, {tableRow(1, QStringLiteral("a"), 10), tableRow(2, QStringLiteral("a"), 20),
+                           tableRow(3, QStringLiteral("a"), 30), tableRow(4, QStringLiteral("a"), 40),
+                           tableRow(5, QStringLiteral("a"), 50)});
+        model.setFilter([](const RowItem *item) { return item->value(2).toInt() < 100; });
+        model.sort(2);
+        QPersistentModelIndex tracked = model.index(0, 0);
+
+        QSignalSpy movedSpy(&model, &QAbstractItemModel::rowsMoved);
+        QSignalSpy removedSpy(&model, &QAbstractItemModel::rowsRemoved);
+        QSignalSpy insertedSpy(&model, &QAbstractItemModel::rowsInserted);
+        QSignalSpy layoutSpy(&model, &QAbstractItemModel::layoutChanged);
+        QSignalSpy resetSpy(&model, &QAbstractItemModel::modelReset);
+
+        model.root()->child(0)->setValue(2, 35);
+        model.flushChanges();
+        QCOMPARE(viewIds(model), (QList<int>{2, 3, 1, 4, 5}));
+        QCOMPARE(movedSpy.count(), 1);
+        QCOMPARE(movedSpy.at(0).at(1).toInt(), 0);
+        QCOMPARE(movedSpy.at(0).at(4).toInt(), 3);
+        QCOMPARE(tracked.row(), 2);
+
+        model.root()->child(3)->setValue(2, 200);
+        model.flushChanges();
+        QCOMPARE(viewIds(model), (QList<int>{2, 3, 1, 5}));
+        QCOMPARE(removedSpy.count(), 1);
+        QVERIFY(!removedSpy.at(0).at(0).value<QModelIndex>().isValid());
+        QCOMPARE(rowRange(removedSpy.at(0)), qMakePair(3, 3));
+
+        model.root()->child(3)->setValue(2, 5);
+        model.flushChanges();
+        QCOMPARE(viewIds(model), (QList<int>{4, 2, 3, 1, 5}));
+        QCOMPARE(insertedSpy.count(), 1);
+        QCOMPARE(rowRange(insertedSpy.at(0)), qMakePair(0, 0));
+        QCOMPARE(tracked.row(), 3);
+
+        QCOMPARE(layoutSpy.count(), 0);
+        QCOMPARE(resetSpy.count(), 0);
+    }
+
+    //排序时增删顶层行按显示位置发出行信号，不重置模型
+    void topLevelRowsUnderView()
+    {
+        RowItemModel model(tableHeaders());
+        appendRows(model, {tableRow(1, QStringLiteral("a"), 10), tableRow(2, QStringLiteral("a"), 20),
+                           tableRow(3, QStringLiteral("a"), 30)});
+        model.sort(2);
+        QPersistentModelIndex tracked = model.index(2, 0);
+
+        QSignalSpy removedSpy(&model, &QAbstractItemModel::rowsRemoved);
+        QSignalSpy insertedSpy(&model, &QAbstractItemModel::rowsInserted);
+        QSignalSpy layoutSpy(&model, &QAbstractItemModel::layoutChanged);
+        QSignalSpy resetSpy(&model, &QAbstractItemModel::modelReset);
+
+        //追加的行按排序放置
+        appendRows(model, {tableRow(4, QStringLiteral("a"), 15)});
+        QCOMPARE(viewIds(model), (QList<int>{1, 4, 2, 3}));
+        QCOMPARE(insertedSpy.count(), 1);
+        QCOMPARE(rowRange(insertedSpy.at(0)), qMakePair(1, 1));
+
+        //insertRows 的新行显示在指定位置
+        QVERIFY(model.insertRows(0, 1));
+        QCOMPARE(viewIds(model), (QList<int>{0, 1, 4, 2, 3}));
+        QCOMPARE(insertedSpy.count(), 2);
+        QCOMPARE(rowRange(insertedSpy.at(1)), qMakePair(0, 0));
+        QCOMPARE(tracked.row(), 4);
+
+        //显示相邻但行号不相邻的两行分两段删除
+        QVERIFY(model.removeRows(2, 2));
+        QCOMPARE(viewIds(model), (QList<int>{0, 1, 3}));
+        QCOMPARE(removedSpy.count(), 2);
+        QCOMPARE(rowRange(removedSpy.at(0)), qMakePair(2, 2));
+        QCOMPARE(rowRange(removedSpy.at(1)), qMakePair(2, 2));
+        QCOMPARE(tracked.row(), 2);
+
+        QCOMPARE(layoutSpy.count(), 0);
+        QCOMPARE(resetSpy.count(), 0);
+    }
+
+    //按键刷新：增删按连续段通知，保留行的顺序变化只发出一次布局变化，只有变化的单元格发出 dataChanged
+    void applySnapshotDiff()
+    {
+        RowItemModel model(tableHeaders());
+        appendRows(model, {tableRow(1, QStringLiteral("a"), 10), tableRow(2, QStringLiteral("a"), 20),
+                           tableRow(3, QStringLiteral("a"), 30), tableRow(4, QStringLiteral("a"), 40),
+                           tableRow(5, QStringLiteral("a"), 50)});
+        QPersistentModelIndex tracked3 = model.index(2, 0);
+        QPersistentModelIndex tracked5 = model.index(4, 0);
+
+        QSignalSpy removedSpy(&model, &QAbstractItemModel::rowsRemoved);
+        QSignalSpy insertedSpy(&model, &QAbstractItemModel::rowsInserted);
+        QSignalSpy layoutSpy(&model, &QAbstractItemModel::layoutChanged);
+        QSignalSpy changedSpy(&model, &QAbstractItemModel::dataChanged);
+        QSignalSpy resetSpy(&model, &QAbstractItemModel::modelReset);
+
+        //删除 2、4，插入 10、11，5 的值变化，保留行的顺序不变
+        model.applySnapshot({tableRow(1, QStringLiteral("a"), 10), tableRow(3, QStringLiteral("a"), 30),
+                             tableRow(10, QStringLiteral("b"), 100), tableRow(5, QStringLiteral("a"), 99),
+                             tableRow(11, QStringLiteral("b"), 110)}, 0);
+        model.flushChanges();
+        QCOMPARE(viewIds(model), (QList<int>{1, 3, 10, 5, 11}));
+        QCOMPARE(removedSpy.count(), 2);
+        QCOMPARE(rowRange(removedSpy.at(0)), qMakePair(3, 3));
+        QCOMPARE(rowRange(removedSpy.at(1)), qMakePair(1, 1));
+        QCOMPARE(insertedSpy.count(), 2);
+        QCOMPARE(rowRange(insertedSpy.at(0)), qMakePair(2, 2));
+        QCOMPARE(rowRange(insertedSpy.at(1)), qMakePair(4, 4));
+        QCOMPARE(layoutSpy.count(), 0);
+        QCOMPARE(changedSpy.count(), 1);
+        QCOMPARE(changedSpy.at(0).at(0).value<QModelIndex>(), model.index(3, 2));
+        QCOMPARE(changedSpy.at(0).at(1).value<QModelIndex>(), model.index(3, 2));
+        QCOMPARE(tracked3.row(), 1);
+        QCOMPARE(tracked5.row(), 3);
+
+        //只调整顺序并原地修改 1 的值
+        removedSpy.clear();
+        insertedSpy.clear();
+        changedSpy.clear();
+        model.applySnapshot({tableRow(11, QStringLiteral("b"), 110), tableRow(5, QStringLiteral("a"), 99),
+                             tableRow(3, QStringLiteral("a"), 30), tableRow(1, QStringLiteral("c"), 10),
+                             tableRow(10, QStringLiteral("b"), 100)}, 0);
+        model.flushChanges();
+        QCOMPARE(viewIds(model), (QList<int>{11, 5, 3, 1, 10}));
+        QCOMPARE(removedSpy.count(), 0);
+        QCOMPARE(insertedSpy.count(), 0);
+        QCOMPARE(layoutSpy.count(), 1);
+        QCOMPARE(changedSpy.count(), 1);
+        QCOMPARE(changedSpy.at(0).at(0).value<QModelIndex>(), model.index(3, 1));
+        QCOMPARE(changedSpy.at(0).at(1).value<QModelIndex>(), model.index(3, 1));
+        QCOMPARE(model.index(3, 1).data().toString(), QStringLiteral("c"));
+        QCOMPARE(tracked3.row(), 2);
+        QCOMPARE(tracked5.row(), 1);
+
+        //内容不变时不发出任何信号
+        layoutSpy.clear();
+        changedSpy.clear();
+        model.applySnapshot({tableRow(11, QStringLiteral("b"), 110), tableRow(5, QStringLiteral("a"), 99),
+                             tableRow(3, QStringLiteral("a"), 30), tableRow(1, QStringLiteral("c"), 10),
+                             tableRow(10, QStringLiteral("b"), 100)}, 0);
+        model.flushChanges();
+        QCOMPARE(removedSpy.count() + insertedSpy.count() + layoutSpy.count() + changedSpy.count(), 0);
+        QCOMPARE(resetSpy.count(), 0);
+    }
+
+    //增删的段数超过阈值时改为一次重置
+    void applySnapshotResetFallback()
+    {
+        const int count = 600;
+        QList<QVariantList> rows;
+        QList<QVariantList> snapshot;
+        QList<int> expected;
+        for (int i = 0; i < count; ++i)
+        {
+            rows.append(tableRow(i, QStringLiteral("a"), i));
+            //奇数行全部换成新键，增删各有 300 段
+            int id = i % 2 == 0 ? i : 1000 + i;
+            snapshot.append(tableRow(id, QStringLiteral("a"), i));
+            expected.append(id);
+        }
+
+        RowItemModel model(tableHeaders());
+        model.beginBulkLoad();
+        appendRows(model, rows);
+        model.endBulkLoad();
+
+        QSignalSpy removedSpy(&model, &QAbstractItemModel::rowsRemoved);
+        QSignalSpy insertedSpy(&model, &QAbstractItemModel::rowsInserted);
+        QSignalSpy resetSpy(&model, &QAbstractItemModel::modelReset);
+        model.applySnapshot(snapshot, 0);
+        model.flushChanges();
+
+        QCOMPARE(viewIds(model), expected);
+        QCOMPARE(resetSpy.count(), 1);
+        QCOMPARE(removedSpy.count(), 0);
+        QCOMPARE(insertedSpy.count(), 0);
+    }
+
+    //多次修改在一次发出中按父节点合并：相邻的行合成一个矩形，列取并集，同一单元格只发出一次
+    void flushMergesAdjacentRows()
+    {
+        RowItemModel model(tableHeaders());
+        for (int i = 0; i < 10; ++i)
+            appendRows(model, {tableRow(i, QStringLiteral("a"), i)});
+        RowItem *parent = model.root()->child(0);
+        for (int i = 0; i < 3; ++i)
+        {
+            RowItem *child = new RowItem(&model);
+            child->setItemData(tableRow(100 + i, QStringLiteral("c"), i));
+            parent->addChild(child);
+        }
+
+        QSignalSpy changedSpy(&model, &QAbstractItemModel::dataChanged);
+        for (int row = 2; row <= 4; ++row)
+            model.root()->child(row)->setValue(1, QStringLiteral("b"));
+        model.root()->child(3)->setValue(2, 33);
+        model.root()->child(7)->setValue(0, 70);
+        model.root()->child(7)->setValue(0, 71);
+        parent->child(0)->setValue(1, QStringLiteral("d"));
+        parent->child(1)->setValue(1, QStringLiteral("d"));
+        QCOMPARE(changedSpy.count(), 0);
+
+        model.flushChanges();
+        QStringList ranges;
+        for (const QList<QVariant> &arguments : changedSpy)
+        {
+            QModelIndex topLeft = arguments.at(0).value<QModelIndex>();
+            QModelIndex bottomRight = arguments.at(1).value<QModelIndex>();
+            QCOMPARE(topLeft.parent(), bottomRight.parent());
+            ranges.append(QStringLiteral("%1:%2-%3:%4-%5")
+                              .arg(topLeft.parent().isValid() ? topLeft.parent().row() : -1)
+                              .arg(topLeft.row()).arg(bottomRight.row())
+                              .arg(topLeft.column()).arg(bottomRight.column()));
+        }
+        ranges.sort();
+        QCOMPARE(ranges, (QStringList{QStringLiteral("-1:2-4:1-2"), QStringLiteral("-1:7-7:0-0"),
+                                      QStringLiteral("0:0-1:1-1")}));
+
+        //已发出的变化不会在事件循环中重复发出
+        QCoreApplication::processEvents();
+        QCOMPARE(changedSpy.count(), 3);
+    }
+
+    void bulkLoad_data()
+    {
+        QTest::addColumn<int>("count");
+        QTest::newRow("10k") << 10000;
+        QTest::newRow("100k") << 100000;
+        QTest::newRow("1M") << 1000000;
+    }
+
+    //批量加载只重置一次模型，测量构建整棵树的耗时
+    void bulkLoad()
+    {
+        QFETCH(int, count);
+        const QList<QVariantList> source = treeSource(count);
+        RowItemModel model(QStringList{QStringLiteral("id"), QStringLiteral("pid"), QStringLiteral("name")});
+        QSignalSpy resetSpy(&model, &QAbstractItemModel::modelReset);
+        QSignalSpy insertSpy(&model, &QAbstractItemModel::rowsInserted);
+
+        const qint64 before = residentMemory();
+        QBENCHMARK {
+            model.clear();
+            model.constructTree(source, 0, 1);
+        }
+        //只有当前实现的数字，没有换用内存池之前的对照
+        const qint64 after = residentMemory();
+        if (before >= 0)
+            qDebug() << count << "nodes, resident memory grows by" << (after - before) / 1024 << "KiB";
+
+        QCOMPARE(countItems(model.root()), count);
+        QCOMPARE(model.rowCount(), 1);
+        QCOMPARE(insertSpy.count(), 0);
+        QVERIFY(resetSpy.count() > 0);
+    }
+};
+
+#endif // TEST_ROWITEMMODEL_H
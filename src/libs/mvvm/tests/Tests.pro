@@ -0,0 +1,24 @@
+QT += testlib widgets concurrent
+CONFIG += c++17
+TARGET = Mvvm_Test
+
+include($$PWD/../src/mvvm-lib.pri)
+include($$PWD/../mvvm-include.pri)
+include($$PWD/../../ioc/src/ioc-lib.pri)
+include($$PWD/../../ioc/ioc-include.pri)
+
+INCLUDEPATH += \
+    $$PWD/../src/connector \
+    $$PWD/../src/models \
+    $$PWD/../src/navigators \
+    $$PWD/../src/properties \
+    $$PWD/../src/viewmodels \
+    $$PWD/../src/views
+
+SOURCES += \
+    $$PWD/main.cpp
+
+HEADERS += \
+    $$PWD/testutils.h \
+    $$PWD/Test_ConnectorContainer.h \
+    $$PWD/Test_RowItemModel.h
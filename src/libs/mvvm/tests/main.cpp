@@ -0,0 +1,17 @@
+#include <QApplication>
+#include <QtTest>
+
+#include "Test_ConnectorContainer.h"
+#include "Test_RowItemModel.h"
+
+int main(int argc, char *argv[])
+{
+    QApplication app(argc, argv);
+    app.setApplicationName("Mvvm Tests");
+
+    int status = 0;
+    status |= QTest::qExec(new Test_ConnectorContainer, argc, argv);
+    status |= QTest::qExec(new Test_RowItemModel, argc, argv);
+
+    return status;
+}
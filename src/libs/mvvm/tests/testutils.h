@@ -0,0 +1,27 @@
+#ifndef TESTUTILS_H
+#define TESTUTILS_H
+
+#include <QtGlobal>
+
+#if defined(Q_OS_LINUX)
+#include <QFile>
+#include <unistd.h>
+#endif
+
+//当前进程的常驻内存（字节），不支持的平台返回 -1
+inline qint64 residentMemory()
+{
+#if defined(Q_OS_LINUX)
+    QFile file(QStringLiteral("/proc/self/statm"));
+    if (!file.open(QIODevice::ReadOnly))
+        return -1;
+    const QList<QByteArray> fields = file.readAll().split(' ');
+    if (fields.size() < 2)
+        return -1;
+    return fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE);
+#else
+    return -1;
+#endif
+}
+
+#endif // TESTUTILS_H